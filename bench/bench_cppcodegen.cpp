@@ -0,0 +1,196 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+
+#include "allocation_counter.h"
+#include "cppcodegen.h"
+
+// Benchmarks of rendering hot paths.
+// Each benchmark reports time, bytes/second of generated code and allocations per iteration,
+// scaling benchmarks also fit time to size (deterministic scaling checks are in tests/unit_tests_complexity.cpp).
+
+namespace {
+
+/**
+ * @brief Report allocations per iteration and generated bytes
+ *
+ */
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State &state)
+      : state_(state), start_(cppcodegen::test::AllocationCount()), bytes_(0) {
+  }
+  ~AllocationCounter() {
+    const std::size_t allocations = cppcodegen::test::AllocationCount() - start_;
+    state_.counters["allocs/op"] =
+        benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    state_.SetBytesProcessed(static_cast<int64_t>(bytes_));
+  }
+  AllocationCounter(const AllocationCounter &) = delete;
+  AllocationCounter &operator=(const AllocationCounter &) = delete;
+
+  void AddBytes(std::size_t bytes) {
+    bytes_ += bytes;
+  }
+
+ private:
+  benchmark::State &state_;
+  std::size_t start_;
+  std::size_t bytes_;
+};
+
+cppcodegen::Class MakeClass(std::size_t index, std::size_t members) {
+  cppcodegen::Class class_block("Generated" + std::to_string(index));
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return value_;";
+  class_block << cppcodegen::AccessSpecifier::kPublic << "Generated" + std::to_string(index) + "() = default;"
+              << getter;
+  class_block << cppcodegen::AccessSpecifier::kPrivate;
+  for (std::size_t member = 0; member < members; member++) {
+    class_block.AddLine("int member_", member, " = ", index, ";");
+  }
+  class_block << "int value_;";
+  return class_block;
+}
+
+}  // namespace
+
+static void BM_SnippetManyLines(benchmark::State &state) {
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    cppcodegen::Snippet snippet(cppcodegen::line_t);
+    for (int64_t line = 0; line < state.range(0); line++) {
+      snippet << "static const int kValue = 0;";
+    }
+    const std::string out = snippet.Out();
+    counter.AddBytes(out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_SnippetManyLines)->Range(1 << 8, 1 << 16);
+
+static void BM_SnippetIncludes(benchmark::State &state) {
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    cppcodegen::Snippet system_include(cppcodegen::system_include_t);
+    cppcodegen::Snippet local_include(cppcodegen::local_include_t, "generated/");
+    for (int64_t line = 0; line < state.range(0); line++) {
+      system_include << "vector";
+      local_include << "header.h";
+    }
+    system_include << local_include;
+    const std::string out = system_include.Out();
+    counter.AddBytes(out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_SnippetIncludes)->Range(1 << 8, 1 << 14);
+
+static void BM_BlockDeepNesting(benchmark::State &state) {
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    cppcodegen::Block block(cppcodegen::code_block_t);
+    block << "int a = 0;";
+    for (int64_t depth = 0; depth < state.range(0); depth++) {
+      cppcodegen::Block parent(cppcodegen::code_block_t);
+      parent << "int a = 0;" << std::move(block);
+      block = std::move(parent);
+    }
+    const std::string out = block.Out();
+    counter.AddBytes(out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_BlockDeepNesting)->Range(1 << 4, 1 << 10)->Complexity();
+
+static void BM_ClassWideBody(benchmark::State &state) {
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    const cppcodegen::Class class_block = MakeClass(0, static_cast<std::size_t>(state.range(0)));
+    const std::string out = class_block.Out();
+    counter.AddBytes(out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ClassWideBody)->Range(1 << 8, 1 << 16)->Complexity(benchmark::oN);
+
+static void BM_IncrementIndentLargeTree(benchmark::State &state) {
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Generated");
+  for (int64_t index = 0; index < state.range(0); index++) {
+    block_namespace << MakeClass(static_cast<std::size_t>(index), 8);
+  }
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    block_namespace.IncrementIndent();
+    benchmark::DoNotOptimize(&block_namespace);
+  }
+}
+BENCHMARK(BM_IncrementIndentLargeTree)->Range(1 << 4, 1 << 12);
+
+static void BM_GenerateHeader(benchmark::State &state) {
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    cppcodegen::Snippet file(cppcodegen::line_t);
+    cppcodegen::Snippet system_include(cppcodegen::system_include_t);
+    cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Generated");
+    file << "#pragma once";
+    system_include << "cstdint"
+                   << "string";
+    for (int64_t index = 0; index < state.range(0); index++) {
+      block_namespace << MakeClass(static_cast<std::size_t>(index), 8);
+    }
+    file << std::move(system_include) << "" << std::move(block_namespace);
+    const std::string out = file.Out();
+    counter.AddBytes(out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_GenerateHeader)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void BM_ParallelGenerateHeader(benchmark::State &state) {
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Generated");
+  for (int64_t index = 0; index < 10000; index++) {
+    block_namespace << MakeClass(static_cast<std::size_t>(index), 64);
+  }
+  cppcodegen::ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    const std::string out = block_namespace.ParallelOut(pool);
+    counter.AddBytes(out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_ParallelGenerateHeader)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_LoadTree(benchmark::State &state) {
+  const std::string path = "bench_cppcodegen_tree.bin";
+  {
+    cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Generated");
+    for (int64_t index = 0; index < state.range(0); index++) {
+      block_namespace << MakeClass(static_cast<std::size_t>(index), 8);
+    }
+    if (!cppcodegen::SaveTree(path, block_namespace)) {
+      state.SkipWithError("SaveTree failed");
+      return;
+    }
+  }
+  std::size_t file_size = 0;
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    file_size = static_cast<std::size_t>(file.tellg());
+  }
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    cppcodegen::Block block_namespace;
+    if (!cppcodegen::LoadTree(path, block_namespace)) {
+      state.SkipWithError("LoadTree failed");
+      break;
+    }
+    counter.AddBytes(file_size);
+    benchmark::DoNotOptimize(&block_namespace);
+  }
+  std::remove(path.c_str());
+}
+BENCHMARK(BM_LoadTree)->Arg(10000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,17 @@
+if(ENABLE_BENCHMARKS)
+    find_package(benchmark QUIET)
+    if(benchmark_FOUND)
+        # imported targets are directory scoped, share them with bench/
+        set_target_properties(benchmark::benchmark benchmark::benchmark_main PROPERTIES IMPORTED_GLOBAL TRUE)
+    else()
+        include(FetchContent)
+        FetchContent_Declare(
+                googlebenchmark
+                URL https://github.com/google/benchmark/archive/refs/tags/v1.7.1.zip
+        )
+        set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+        set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+        set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+        FetchContent_MakeAvailable(googlebenchmark)
+    endif()
+endif()
@@ -1,9 +1,33 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
 namespace cppcodegen {
 
 const std::size_t kDefaultIndentSize = 2;
@@ -45,6 +69,50 @@ constexpr StructType struct_t{};
 enum class Type { kLine, kSystemInclude, kLocalInclude, kCodeBlock, kDefinition, kNamespace, kClass, kStruct };
 enum class AccessSpecifier { kPublic, kProtected, kPrivate };
 
+namespace detail {
+
+/**
+ * @brief Process-wide table of indent prefixes
+ *
+ * @details
+ * One contiguous read-only buffer holds kWidth copies of every character value.
+ * Prefix of (level, size, character) is the first level * size bytes of the character row,
+ * so indenting never allocates. The table is built once on first use (thread-safe static initialization).
+ */
+class IndentCache {
+ public:
+  static const std::size_t kWidth = 256;
+
+  static const char *Row(char character) noexcept {
+    static const IndentCache cache;
+    return cache.table_ + static_cast<unsigned char>(character) * kWidth;
+  }
+
+  template <typename Sink>
+  static void IndentTo(Sink &sink, std::size_t width, char character) noexcept {
+    const char *row = Row(character);
+    while (width > kWidth) {
+      sink.Write(row, kWidth);
+      width -= kWidth;
+    }
+    if (width > 0) {
+      sink.Write(row, width);
+    }
+    return;
+  }
+
+ private:
+  IndentCache() noexcept {
+    for (std::size_t character = 0; character < 256; character++) {
+      std::memset(table_ + character * kWidth, static_cast<int>(character), kWidth);
+    }
+  }
+
+  char table_[256 * kWidth];
+};
+
+}  // namespace detail
+
 /**
  * @brief Indent information holder
  *
@@ -52,11 +120,6 @@ enum class AccessSpecifier { kPublic, kProtected, kPrivate };
 typedef struct Indent {
   Indent(std::size_t level, std::size_t size, char character = ' ')
       : level_(level), size_(size), character_(character) {
-    std::size_t index = 0;
-    while (index < size_) {
-      indent_string_ += character_;
-      index++;
-    }
   }
   ~Indent() = default;
   Indent(const Indent &) = default;
@@ -67,381 +130,4665 @@ typedef struct Indent {
   std::size_t level_;
   std::size_t size_;
   char character_;
-  std::string indent_string_;
 
   std::string Indenting() const noexcept {
-    std::string total_indent;
-    std::size_t level = 0;
-    while (level < level_) {
-      total_indent += indent_string_;
-      level++;
-    }
-    return total_indent;
+    return std::string(Width(), character_);
   }
-} Indent;
 
-/**
- * @brief Snippet
- *
- */
-class Snippet {
- public:
-  /**
-   * @brief Construct a new Snippet object as default : Line
-   *
-   * @param indent
-   */
-  Snippet(const Indent &indent = Indent(0, kDefaultIndentSize)) : Snippet(LineType(), indent) {
-  }
-  /**
-   * @brief Construct a new Snippet object as Line
-   *
-   * @param indent
-   */
-  Snippet(LineType, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent), header_(), footer_(), type_(Type::kLine) {
+  std::size_t Width() const noexcept {
+    return level_ * size_;
   }
+
   /**
-   * @brief Construct a new Snippet object as system include
+   * @brief Write indent into sink from shared indent cache
    *
-   * @param indent
+   * @tparam Sink
+   * @param sink
    */
-  Snippet(SystemIncludeType, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent), header_("#include <"), footer_(">"), type_(Type::kSystemInclude) {
+  template <typename Sink>
+  void IndentTo(Sink &sink) const noexcept {
+    detail::IndentCache::IndentTo(sink, Width(), character_);
+    return;
   }
-  /**
-   * @brief Construct a new Snippet object as local include
-   *
-   * @param base_dir_path include relative base path
-   * @param indent
-   */
-  Snippet(LocalIncludeType, const std::string base_dir_path, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent), header_("#include \"" + base_dir_path), footer_("\""), type_(Type::kLocalInclude) {
+} Indent;
+
+/**
+ * @brief Sink appending into std::string (growable buffer)
+ *
+ */
+class StringSink {
+ public:
+  explicit StringSink(std::string &buffer) : buffer_(buffer) {
   }
-  ~Snippet() = default;
-  Snippet(const Snippet &) = default;
-  Snippet &operator=(const Snippet &) = default;
-  Snippet(Snippet &&) = default;
-  Snippet &operator=(Snippet &&) = default;
 
-  /**
-   * @brief Out with own indent
-   *
-   * @return std::string
-   */
-  std::string Out() const noexcept {
-    std::string snippet;
-    for (const auto &line : lines_) {
-      snippet += indent_.Indenting() + line + "\n";
-    }
-    return snippet;
+  void Write(const char *data, std::size_t size) noexcept {
+    buffer_.append(data, size);
+    return;
   }
 
-  Type GetType() const noexcept {
-    return type_;
+ private:
+  std::string &buffer_;
+};
+
+/**
+ * @brief Sink writing into std::ostream
+ *
+ */
+class OstreamSink {
+ public:
+  explicit OstreamSink(std::ostream &stream) : stream_(stream) {
   }
 
-  void Add(const std::string &line) noexcept {
-    lines_.emplace_back(header_ + line + footer_);
+  void Write(const char *data, std::size_t size) noexcept {
+    stream_.write(data, static_cast<std::streamsize>(size));
     return;
   }
 
-  /**
-   * @brief Add any type snippet as lines
-   *
-   * @tparam T
-   * @param any
-   */
-  template <typename T>
-  void Add(const T &any) noexcept {
-    std::stringstream line_stream(any.Out());
-    std::string line;
-    while (std::getline(line_stream, line)) {
-      lines_.emplace_back(line);
+ private:
+  std::ostream &stream_;
+};
+
+/**
+ * @brief Sink writing into FILE*
+ *
+ */
+class FileSink {
+ public:
+  explicit FileSink(std::FILE *file) : file_(file), good_(file != nullptr) {
+  }
+
+  void Write(const char *data, std::size_t size) noexcept {
+    if (good_ && std::fwrite(data, 1, size, file_) != size) {
+      good_ = false;
     }
     return;
   }
-  void Add(const char characters[]) noexcept {
-    Add(std::string(characters));
-    return;
+
+  bool Good() const noexcept {
+    return good_;
   }
 
-  void Add(const std::vector<std::string> &lines) noexcept {
-    for (const auto &line : lines) {
-      Add(line);
-    }
-    return;
+ private:
+  std::FILE *file_;
+  bool good_;
+};
+
+/**
+ * @brief Sink copying into preallocated buffer
+ *
+ * @details
+ * buffer must be large enough, e.g. sized by OutSize().
+ */
+class BufferSink {
+ public:
+  explicit BufferSink(char *buffer) : cursor_(buffer) {
   }
 
-  void IncrementIndent(std::size_t level = 1) noexcept {
-    indent_.level_ += level;
+  void Write(const char *data, std::size_t size) noexcept {
+    std::memcpy(cursor_, data, size);
+    cursor_ += size;
     return;
   }
 
+  char *Cursor() const noexcept {
+    return cursor_;
+  }
+
  private:
-  Indent indent_;
-  std::string header_;
-  std::string footer_;
-  Type type_;
-  std::vector<std::string> lines_;
+  char *cursor_;
 };
 
 /**
- * @brief Codeblock
+ * @brief Sink comparing written bytes with contents of FILE*, nothing is written
  *
  */
-class Block {
+class CompareSink {
  public:
-  /**
-   * @brief Construct a new Block object as default : codeblock
-   *
-   * @param indent
-   */
-  Block(const Indent &indent = Indent(0, kDefaultIndentSize)) : Block(CodeBlockType(), indent) {
+  explicit CompareSink(std::FILE *file) : file_(file), equal_(file != nullptr) {
   }
-  /**
-   * @brief Construct a new Block object as codeblock
-   *
-   * @param indent
-   */
-  Block(CodeBlockType, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent), header_("{\n"), footer_("}\n"), type_(Type::kCodeBlock) {
+
+  void Write(const char *data, std::size_t size) noexcept {
+    while (equal_ && size > 0) {
+      const std::size_t chunk = size < sizeof(buffer_) ? size : sizeof(buffer_);
+      if (std::fread(buffer_, 1, chunk, file_) != chunk || std::memcmp(buffer_, data, chunk) != 0) {
+        equal_ = false;
+      }
+      data += chunk;
+      size -= chunk;
+    }
+    return;
   }
+
   /**
-   * @brief Construct a new Block object as definition
+   * @brief All bytes written so far equal to file
    *
-   * @param indent
+   * @return true
+   * @return false
    */
-  Block(DefinitionType, const std::string &declaration, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent), header_(declaration + " {\n"), footer_("}\n"), type_(Type::kDefinition) {
+  bool Equal() const noexcept {
+    return equal_;
+  }
+
+ private:
+  std::FILE *file_;
+  bool equal_;
+  char buffer_[4096];
+};
+
+/**
+ * @brief Sink computing 64bit fingerprint of written bytes (XXH64), nothing is stored
+ *
+ * @details
+ * digest depends only on the byte sequence, not on how it is split into writes,
+ * and is the same on every run and platform (bytes are read as little endian), so it can be a persistent cache key.
+ */
+class HashSink {
+ public:
+  explicit HashSink(std::uint64_t seed = 0) noexcept
+      : seed_(seed),
+        lanes_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1},
+        size_(0),
+        buffered_(0) {
+  }
+
+  void Write(const char *data, std::size_t size) noexcept {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    size_ += size;
+    if (buffered_ > 0) {
+      const std::size_t copied = size < kStripe - buffered_ ? size : kStripe - buffered_;
+      std::memcpy(buffer_ + buffered_, bytes, copied);
+      buffered_ += copied;
+      bytes += copied;
+      size -= copied;
+      if (buffered_ < kStripe) {
+        return;
+      }
+      Stripe(buffer_);
+      buffered_ = 0;
+    }
+    for (; size >= kStripe; bytes += kStripe, size -= kStripe) {
+      Stripe(bytes);
+    }
+    std::memcpy(buffer_, bytes, size);
+    buffered_ = size;
+    return;
   }
+
   /**
-   * @brief Construct a new Block object as namespace
+   * @brief Fingerprint of all bytes written so far
    *
-   * @param name
-   * @param indent
+   * @return std::uint64_t
    */
-  Block(NamespaceType, const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent), header_("namespace " + name + " {\n"), footer_("}\n"), type_(Type::kNamespace) {
+  std::uint64_t Digest() const noexcept {
+    std::uint64_t hash;
+    if (size_ >= kStripe) {
+      hash = Rotate(lanes_[0], 1) + Rotate(lanes_[1], 7) + Rotate(lanes_[2], 12) + Rotate(lanes_[3], 18);
+      for (const auto lane : lanes_) {
+        hash = (hash ^ Round(0, lane)) * kPrime1 + kPrime4;
+      }
+    } else {
+      hash = seed_ + kPrime5;
+    }
+    hash += static_cast<std::uint64_t>(size_);
+    std::size_t offset = 0;
+    for (; offset + 8 <= buffered_; offset += 8) {
+      hash ^= Round(0, Read(buffer_ + offset, 8));
+      hash = Rotate(hash, 27) * kPrime1 + kPrime4;
+    }
+    if (offset + 4 <= buffered_) {
+      hash ^= Read(buffer_ + offset, 4) * kPrime1;
+      hash = Rotate(hash, 23) * kPrime2 + kPrime3;
+      offset += 4;
+    }
+    for (; offset < buffered_; offset++) {
+      hash ^= buffer_[offset] * kPrime5;
+      hash = Rotate(hash, 11) * kPrime1;
+    }
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
   }
-  ~Block() = default;
-  Block(const Block &) = default;
-  Block &operator=(const Block &) = default;
-  Block(Block &&) = default;
-  Block &operator=(Block &&) = default;
 
   /**
-   * @brief Out with own indent
+   * @brief Written bytes
    *
-   * @return std::string
+   * @return std::size_t
    */
-  std::string Out() const noexcept {
-    std::string block = indent_.Indenting() + header_;
-    for (const auto &snippet : snippets_) {
-      block += snippet.Out();
-    }
-    block += indent_.Indenting() + footer_;
-    return block;
+  std::size_t Size() const noexcept {
+    return size_;
   }
 
-  Type GetType() const noexcept {
-    return type_;
+ private:
+  static const std::uint64_t kPrime1 = 11400714785074694791ULL;
+  static const std::uint64_t kPrime2 = 14029467366897019727ULL;
+  static const std::uint64_t kPrime3 = 1609587929392839161ULL;
+  static const std::uint64_t kPrime4 = 9650029242287828579ULL;
+  static const std::uint64_t kPrime5 = 2870177450012600261ULL;
+  static const std::size_t kStripe = 32;
+
+  static std::uint64_t Rotate(std::uint64_t value, int bits) noexcept {
+    return (value << bits) | (value >> (64 - bits));
   }
 
-  void Add(const std::vector<std::string> &lines) noexcept {
-    for (const auto &line : lines) {
-      Add(line);
+  static std::uint64_t Round(std::uint64_t lane, std::uint64_t input) noexcept {
+    return Rotate(lane + input * kPrime2, 31) * kPrime1;
+  }
+
+  static std::uint64_t Read(const unsigned char *bytes, std::size_t size) noexcept {
+    std::uint64_t value = 0;
+    for (std::size_t index = size; index > 0; index--) {
+      value = (value << 8) | bytes[index - 1];
     }
-    return;
+    return value;
   }
 
-  template <typename T>
-  void Add(const T &any) noexcept {
-    Snippet snippet_copy(Indent(indent_.level_ + 1, indent_.size_));
-    snippets_.emplace_back(std::move(snippet_copy << any));
+  void Stripe(const unsigned char *bytes) noexcept {
+    for (std::size_t lane = 0; lane < 4; lane++) {
+      lanes_[lane] = Round(lanes_[lane], Read(bytes + lane * 8, 8));
+    }
     return;
   }
 
-  void IncrementIndent(std::size_t level = 1) noexcept {
-    indent_.level_ += level;
-    for (auto &&snippet : snippets_) {
-      snippet.IncrementIndent(level);
+  std::uint64_t seed_;
+  std::uint64_t lanes_[4];
+  std::size_t size_;
+  std::size_t buffered_;
+  unsigned char buffer_[kStripe];
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * @brief Sink writing into POSIX file descriptor
+ *
+ */
+class FdSink {
+ public:
+  explicit FdSink(int fd) : fd_(fd), good_(fd >= 0) {
+  }
+
+  void Write(const char *data, std::size_t size) noexcept {
+    while (good_ && size > 0) {
+      ssize_t written = ::write(fd_, data, size);
+      if (written < 0) {
+        if (errno != EINTR) {
+          good_ = false;
+        }
+        continue;
+      }
+      data += written;
+      size -= static_cast<std::size_t>(written);
     }
     return;
   }
 
+  bool Good() const noexcept {
+    return good_;
+  }
+
  private:
-  Indent indent_;
-  std::string header_;
-  std::string footer_;
-  Type type_;
-  std::vector<Snippet> snippets_;
+  int fd_;
+  bool good_;
 };
+#endif
 
 /**
- * @brief Class and Struct
+ * @brief Monotonic storage for line bytes
  *
+ * @details
+ * Lines are appended into large contiguous chunks and never freed one by one,
+ * the whole document is released in one step when the last node holding the arena is destroyed.
+ * one arena can be shared by whole document. it is not locked unless constructed synchronized,
+ * which is needed only when nodes sharing it are built on different threads.
  */
-class Class {
+class Arena {
  public:
+  static const std::size_t kInitialChunkSize = 256;
+  static const std::size_t kDefaultChunkSize = 64 * 1024;
+
   /**
-   * @brief Construct a new Class object default : class
+   * @brief Construct a new Arena object
    *
-   * @param name
-   * @param indent
+   * @param chunk_size max chunk size, chunks grow from kInitialChunkSize up to this size
+   * @param synchronized lock on every call, for arena shared by nodes built on different threads
    */
-  Class(const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : Class(ClassType(), name, indent) {
+  explicit Arena(std::size_t chunk_size = kDefaultChunkSize, bool synchronized = false)
+      : synchronized_(synchronized),
+        chunk_size_(chunk_size),
+        next_chunk_size_(kInitialChunkSize < chunk_size ? kInitialChunkSize : chunk_size),
+        cursor_(nullptr),
+        remaining_(0),
+        used_(0),
+        reserved_(0) {
   }
+  ~Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  Arena(Arena &&) = delete;
+  Arena &operator=(Arena &&) = delete;
+
   /**
-   * @brief Construct a new Class object as class
+   * @brief Allocate bytes which stay valid while arena alive
    *
-   * @param name
-   * @param indent
-   * @details
-   * default access specifier is private.
+   * @param size
+   * @return char*
    */
-  Class(ClassType, const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent),
-        name_(name),
-        header_(" {\n"),
-        footer_("};\n"),
-        type_(Type::kClass),
-        snippets_({{AccessSpecifier::kPrivate, {}}, {AccessSpecifier::kPublic, {}}, {AccessSpecifier::kProtected, {}}}),
-        now_specifier_(AccessSpecifier::kPrivate) {
+  char *Allocate(std::size_t size) noexcept {
+    static char empty = '\0';
+    if (size == 0) {
+      return &empty;
+    }
+    const std::unique_lock<std::mutex> lock = Lock();
+    if (size > remaining_) {
+      std::size_t chunk_size = next_chunk_size_;
+      if (next_chunk_size_ < chunk_size_) {
+        next_chunk_size_ = next_chunk_size_ * 2 < chunk_size_ ? next_chunk_size_ * 2 : chunk_size_;
+      }
+      if (chunk_size < size) {
+        chunk_size = size;
+      }
+      chunks_.emplace_back(new char[chunk_size]);
+      cursor_ = chunks_.back().get();
+      remaining_ = chunk_size;
+      reserved_ += chunk_size;
+    }
+    char *allocated = cursor_;
+    cursor_ += size;
+    remaining_ -= size;
+    used_ += size;
+    return allocated;
   }
+
   /**
-   * @brief Construct a new Class object as class with inheritances
+   * @brief Take over buffer of string, bytes stay valid while arena alive
    *
-   * @param name
-   * @param inheritances inheritance access specifiers and class names
-   * @param indent
+   * @param buffer
+   * @return const char*
    */
-  Class(ClassType, const std::string &name, const std::vector<std::pair<AccessSpecifier, std::string>> inheritances,
-        const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent),
-        name_(name),
-        header_(" {\n"),
-        footer_("};\n"),
-        type_(Type::kClass),
-        snippets_({{AccessSpecifier::kPrivate, {}}, {AccessSpecifier::kPublic, {}}, {AccessSpecifier::kProtected, {}}}),
-        now_specifier_(AccessSpecifier::kPrivate) {
-    for (const auto &inheritance : inheritances) {
-      AddInheritance(inheritance.second, inheritance.first);
-    }
+  const char *Adopt(std::string &&buffer) noexcept {
+    const std::unique_lock<std::mutex> lock = Lock();
+    adopted_.push_back(std::move(buffer));
+    used_ += adopted_.back().size();
+    reserved_ += adopted_.back().capacity();
+    return adopted_.back().data();
   }
+
   /**
-   * @brief Construct a new Class object as struct
+   * @brief Keep other arena alive as long as this one, e.g. lines merged from other document
    *
-   * @param name
-   * @param indent
+   * @param other
    * @details
-   * default access specifier is public.
+   * attaching arenas to each other in a cycle leaks them.
    */
-  Class(StructType, const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
-      : indent_(indent),
-        name_(name),
-        header_(" {\n"),
-        footer_("};\n"),
-        type_(Type::kStruct),
-        snippets_({{AccessSpecifier::kPrivate, {}}, {AccessSpecifier::kPublic, {}}, {AccessSpecifier::kProtected, {}}}),
-        now_specifier_(AccessSpecifier::kPublic) {
+  void Attach(const std::shared_ptr<Arena> &other) noexcept {
+    if (other && other.get() != this) {
+      const std::unique_lock<std::mutex> lock = Lock();
+      if (attached_.empty() || attached_.back() != other) {
+        attached_.push_back(other);
+      }
+    }
+    return;
+  }
+
+  /**
+   * @brief Keep object alive as long as this arena, e.g. mapped file which lines point into
+   *
+   * @param keepalive
+   */
+  void Keep(const std::shared_ptr<const void> &keepalive) noexcept {
+    const std::unique_lock<std::mutex> lock = Lock();
+    kept_.push_back(keepalive);
+    return;
+  }
+
+  /**
+   * @brief Allocated bytes, including attached arenas
+   *
+   * @return std::size_t
+   */
+  std::size_t Used() const noexcept {
+    std::size_t used = 0;
+    for (const auto &attached : Attached()) {
+      used += attached->Used();
+    }
+    const std::unique_lock<std::mutex> lock = Lock();
+    return used + used_;
+  }
+
+  /**
+   * @brief Reserved bytes of all chunks, including attached arenas
+   *
+   * @return std::size_t
+   */
+  std::size_t Reserved() const noexcept {
+    std::size_t reserved = 0;
+    for (const auto &attached : Attached()) {
+      reserved += attached->Reserved();
+    }
+    const std::unique_lock<std::mutex> lock = Lock();
+    return reserved + reserved_;
+  }
+
+  bool Synchronized() const noexcept {
+    return synchronized_;
+  }
+
+ private:
+  /**
+   * @brief Lock of synchronized arena, owns nothing otherwise
+   *
+   * @return std::unique_lock<std::mutex>
+   */
+  std::unique_lock<std::mutex> Lock() const noexcept {
+    return synchronized_ ? std::unique_lock<std::mutex>(mutex_) : std::unique_lock<std::mutex>();
+  }
+
+  const bool synchronized_;
+  mutable std::mutex mutex_;
+  std::size_t chunk_size_;
+  std::size_t next_chunk_size_;
+  std::vector<std::shared_ptr<Arena>> Attached() const noexcept {
+    const std::unique_lock<std::mutex> lock = Lock();
+    return attached_;
+  }
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  std::deque<std::string> adopted_;
+  std::vector<std::shared_ptr<Arena>> attached_;
+  std::vector<std::shared_ptr<const void>> kept_;
+  char *cursor_;
+  std::size_t remaining_;
+  std::size_t used_;
+  std::size_t reserved_;
+};
+
+/**
+ * @brief Temporary file holding rendered subtrees beyond a memory ceiling, read back while rendering
+ *
+ * @details
+ * subtree is written as rendered at top level; indent of its parents goes before each of its lines,
+ * so it reads back under any parent indent and line bytes are kept as they are. resident bytes count subtrees
+ * kept in memory since creation (by rendered size) and only grow. the file is created on first spill and removed
+ * when closed. offsets are 64bit, so the file may grow beyond 2GB. all methods are thread-safe;
+ * subtree is rendered without lock into range reserved by its size, so it may read back spilled children.
+ */
+class SpillFile {
+ public:
+  typedef struct Range {
+    std::uint64_t offset_;
+    std::size_t size_;
+    std::size_t lines_;
+  } Range;
+
+  /**
+   * @brief Sink writing into reserved range of file through buffer, counting lines
+   *
+   */
+  class Writer {
+   public:
+    Writer(SpillFile &file, const Range &range) noexcept
+        : file_(file), range_(range), buffered_(0), written_(0), lines_(0), good_(true) {
+    }
+    void Write(const char *data, std::size_t size) noexcept {
+      const char line_break = '\n';
+      lines_ += static_cast<std::size_t>(std::count(data, data + size, line_break));
+      while (size > 0) {
+        const std::size_t chunk = std::min(size, sizeof(buffer_) - buffered_);
+        std::memcpy(buffer_ + buffered_, data, chunk);
+        buffered_ += chunk;
+        data += chunk;
+        size -= chunk;
+        if (buffered_ == sizeof(buffer_)) {
+          Flush();
+        }
+      }
+      return;
+    }
+
+   private:
+    friend class SpillFile;
+
+    void Flush() noexcept {
+      if (buffered_ > 0) {
+        good_ = good_ && written_ + buffered_ <= range_.size_ &&
+                file_.WriteAt(range_.offset_ + written_, buffer_, buffered_);
+        written_ += buffered_;
+        buffered_ = 0;
+      }
+      return;
+    }
+
+    SpillFile &file_;
+    const Range &range_;
+    std::size_t buffered_;
+    std::size_t written_;
+    std::size_t lines_;
+    bool good_;
+    char buffer_[16 * 1024];
+  };
+
+  /**
+   * @brief Construct a new SpillFile object
+   *
+   * @param ceiling resident bytes, subtrees beyond are spilled
+   */
+  explicit SpillFile(std::size_t ceiling) noexcept
+      : ceiling_(ceiling), resident_(0), spilled_(0), file_(nullptr), good_(true) {
+  }
+  ~SpillFile() {
+    if (file_ != nullptr) {
+      std::fclose(file_);
+    }
+  }
+  SpillFile(const SpillFile &) = delete;
+  SpillFile &operator=(const SpillFile &) = delete;
+  SpillFile(SpillFile &&) = delete;
+  SpillFile &operator=(SpillFile &&) = delete;
+
+  /**
+   * @brief Count size as resident if within ceiling
+   *
+   * @param size
+   * @return true keep in memory
+   * @return false spill
+   */
+  bool Reserve(std::size_t size) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (resident_ + size > ceiling_) {
+      return false;
+    }
+    resident_ += size;
+    return true;
+  }
+
+  /**
+   * @brief Reserve size bytes at the end of file and fill them with bytes written by render
+   *
+   * @tparam Render callable with Writer &
+   * @param render writes exactly size bytes, called without lock
+   * @param size
+   * @param range written range
+   * @return true
+   * @return false file could not be created or written, nothing is spilled and reserved bytes stay unused
+   */
+  template <typename Render>
+  bool Spill(Render &&render, std::size_t size, Range &range) noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (file_ == nullptr) {
+        file_ = std::tmpfile();
+        if (file_ == nullptr) {
+          return false;
+        }
+      }
+      range = {spilled_, size, 0};
+      spilled_ += size;
+    }
+    Writer writer(*this, range);
+    render(writer);
+    writer.Flush();
+    if (!writer.good_ || writer.written_ != size) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::fflush(file_) != 0) {
+      return false;
+    }
+    range.lines_ = writer.lines_;
+    return true;
+  }
+
+  /**
+   * @brief Read bytes at offset of file
+   *
+   * @param offset
+   * @param buffer
+   * @param size
+   * @return true
+   * @return false size bytes could not be read, Good() turns false
+   */
+  bool Read(std::uint64_t offset, char *buffer, std::size_t size) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr || !Seek(offset) || std::fread(buffer, 1, size, file_) != size) {
+      good_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  std::size_t Resident() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_;
+  }
+
+  std::uint64_t Spilled() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return spilled_;
+  }
+
+  /**
+   * @brief No read back failed, otherwise output rendered since is truncated
+   *
+   * @return true
+   * @return false
+   */
+  bool Good() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return good_;
+  }
+
+ private:
+  bool WriteAt(std::uint64_t offset, const char *data, std::size_t size) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Seek(offset) && std::fwrite(data, 1, size, file_) == size;
+  }
+
+  bool Seek(std::uint64_t offset) noexcept {
+#if defined(_WIN32)
+    return offset <= static_cast<std::uint64_t>(std::numeric_limits<__int64>::max()) &&
+           _fseeki64(file_, static_cast<__int64>(offset), SEEK_SET) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    return offset <= static_cast<std::uint64_t>(std::numeric_limits<off_t>::max()) &&
+           fseeko(file_, static_cast<off_t>(offset), SEEK_SET) == 0;
+#else
+    return offset <= static_cast<std::uint64_t>(std::numeric_limits<long>::max()) &&
+           std::fseek(file_, static_cast<long>(offset), SEEK_SET) == 0;
+#endif
+  }
+
+  mutable std::mutex mutex_;
+  std::size_t ceiling_;
+  std::size_t resident_;
+  std::uint64_t spilled_;
+  std::FILE *file_;
+  bool good_;
+};
+
+namespace detail {
+
+/**
+ * @brief 64bit hash of bytes and combination of hashes
+ *
+ * @details
+ * fixed constants, no per-process seed, so the same content hashes the same on every run.
+ */
+class Hasher {
+ public:
+  static const std::uint64_t kSeed = 0xcbf29ce484222325ULL;
+
+  /**
+   * @brief FNV-1a of bytes, continued from hash
+   *
+   */
+  static std::uint64_t Bytes(const char *data, std::size_t size, std::uint64_t hash = kSeed) noexcept {
+    for (std::size_t index = 0; index < size; index++) {
+      hash ^= static_cast<unsigned char>(data[index]);
+      hash *= 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  /**
+   * @brief Order dependent combination with splitmix64 finalizer
+   *
+   */
+  static std::uint64_t Combine(std::uint64_t seed, std::uint64_t value) noexcept {
+    std::uint64_t hash = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+  }
+
+  /**
+   * @brief Append value to polynomial hash of sequence, so hashes of parts are joined by Concat() without rehashing
+   *
+   */
+  static std::uint64_t Fold(std::uint64_t hash, std::uint64_t value) noexcept {
+    return hash * kFold + Combine(0, value);
+  }
+
+  /**
+   * @brief Hash of count values folded from zero, taken from hashes before and after folding them
+   *
+   */
+  static std::uint64_t Range(std::uint64_t before, std::uint64_t after, std::size_t count) noexcept {
+    return after - before * Power(count);
+  }
+
+  /**
+   * @brief Fold count values whose Range() is range, in O(log count)
+   *
+   */
+  static std::uint64_t Concat(std::uint64_t hash, std::uint64_t range, std::size_t count) noexcept {
+    return hash * Power(count) + range;
+  }
+
+  static std::uint64_t Combine(std::uint64_t seed, const Indent &indent) noexcept {
+    seed = Combine(seed, static_cast<std::uint64_t>(indent.level_));
+    seed = Combine(seed, static_cast<std::uint64_t>(indent.size_));
+    return Combine(seed, static_cast<std::uint64_t>(static_cast<unsigned char>(indent.character_)));
+  }
+
+  static std::uint64_t Combine(std::uint64_t seed, const std::string &bytes) noexcept {
+    return Combine(seed, Bytes(bytes.data(), bytes.size()));
+  }
+
+ private:
+  static const std::uint64_t kFold = 0x9e3779b97f4a7c15ULL;
+
+  static std::uint64_t Power(std::size_t count) noexcept {
+    std::uint64_t power = 1;
+    std::uint64_t base = kFold;
+    for (; count > 0; count >>= 1) {
+      if ((count & 1) != 0) {
+        power *= base;
+      }
+      base *= base;
+    }
+    return power;
+  }
+};
+
+}  // namespace detail
+
+/**
+ * @brief Rendered bytes of subtrees keyed by structural hash and indent prefix
+ *
+ * @details
+ * identical subtree under identical indent is rendered once, later occurrences are copied from cache.
+ * keys are content hashes, so one cache can be reused across Out() of edited trees.
+ * lookup is probabilistic: content is not compared, only top level size of the subtree (entries and header bytes)
+ * is stored with the key and checked, so a wrong hit needs a 64bit hash collision of subtrees of equal size.
+ * bytes are stored until capacity is reached, then the cache only serves lookups.
+ * not thread-safe, use one cache per rendering thread.
+ */
+class RenderCache {
+ public:
+  static const std::size_t kDefaultCapacity = 64 * 1024 * 1024;
+
+  explicit RenderCache(std::size_t capacity = kDefaultCapacity) : capacity_(capacity), bytes_(0), hits_(0), misses_(0) {
+  }
+  ~RenderCache() = default;
+  RenderCache(const RenderCache &) = delete;
+  RenderCache &operator=(const RenderCache &) = delete;
+  RenderCache(RenderCache &&) = default;
+  RenderCache &operator=(RenderCache &&) = default;
+
+  /**
+   * @brief Cached bytes of key stored with the same size, or nullptr (counts hit or miss)
+   *
+   * @param key
+   * @param size top level size of subtree, guard against hash collision
+   * @return const std::string*
+   */
+  const std::string *Find(std::uint64_t key, std::size_t size) noexcept {
+    auto found = rendered_.find(key);
+    if (found == rendered_.end() || found->second.size_ != size) {
+      misses_++;
+      return nullptr;
+    }
+    hits_++;
+    return &found->second.rendered_;
+  }
+
+  void Store(std::uint64_t key, std::size_t size, std::string &&rendered) noexcept {
+    if (bytes_ + rendered.size() <= capacity_) {
+      auto found = rendered_.find(key);
+      if (found != rendered_.end()) {
+        bytes_ -= found->second.rendered_.size();
+        rendered_.erase(found);
+      }
+      bytes_ += rendered.size();
+      rendered_.emplace(key, Rendered{size, std::move(rendered)});
+    }
+    return;
+  }
+
+  void Clear() noexcept {
+    rendered_.clear();
+    bytes_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+    return;
+  }
+
+  std::size_t Hits() const noexcept {
+    return hits_;
+  }
+
+  std::size_t Misses() const noexcept {
+    return misses_;
+  }
+
+  /**
+   * @brief Stored rendered bytes
+   *
+   * @return std::size_t
+   */
+  std::size_t Bytes() const noexcept {
+    return bytes_;
+  }
+
+ private:
+  std::size_t capacity_;
+  std::size_t bytes_;
+  std::size_t hits_;
+  std::size_t misses_;
+
+  typedef struct Rendered {
+    std::size_t size_;
+    std::string rendered_;
+  } Rendered;
+  std::unordered_map<std::uint64_t, Rendered> rendered_;
+};
+
+/**
+ * @brief Fixed set of worker threads, executor of parallel rendering
+ *
+ * @details
+ * any executor type with the same Run() can be passed to ParallelOut() instead, e.g. adaptor of existing pool.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Construct a new Thread Pool object
+   *
+   * @param threads number of threads including the thread calling Run()
+   */
+  explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency())
+      : task_(nullptr), count_(0), next_(0), pending_(0), active_(0), generation_(0), stop_(false) {
+    for (std::size_t thread = 1; thread < threads; thread++) {
+      workers_.emplace_back([this]() { Work(); });
+    }
+  }
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &&worker : workers_) {
+      worker.join();
+    }
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+
+  std::size_t Size() const noexcept {
+    return workers_.size() + 1;
+  }
+
+  /**
+   * @brief Call task(0) ... task(count - 1) on all threads, return when all finished
+   *
+   * @param count
+   * @param task
+   */
+  void Run(std::size_t count, const std::function<void(std::size_t)> &task) noexcept {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this]() { return active_ == 0; });
+      task_ = &task;
+      count_ = count;
+      next_.store(0);
+      pending_.store(count);
+      generation_++;
+    }
+    wake_.notify_all();
+    Drain();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_.load() == 0; });
+    return;
+  }
+
+ private:
+  void Work() noexcept {
+    std::size_t generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this, generation]() { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      active_++;
+      lock.unlock();
+      Drain();
+      lock.lock();
+      active_--;
+      done_.notify_all();
+    }
+  }
+
+  void Drain() noexcept {
+    while (true) {
+      const std::size_t index = next_.fetch_add(1);
+      if (index >= count_) {
+        return;
+      }
+      (*task_)(index);
+      if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+      }
+    }
+  }
+
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(std::size_t)> *task_;
+  std::size_t count_;
+  std::atomic<std::size_t> next_;
+  std::atomic<std::size_t> pending_;
+  std::size_t active_;
+  std::size_t generation_;
+  bool stop_;
+  std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Worker threads with own task queues, idle worker steals from others
+ *
+ * @details
+ * tasks are dealt in contiguous ranges, and uneven task costs (e.g. file sizes) are balanced by stealing.
+ * same Run() as ThreadPool, usable as executor of ParallelOut() and Project.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * @brief Construct a new Work Stealing Pool object
+   *
+   * @param threads number of threads including the thread calling Run()
+   */
+  explicit WorkStealingPool(std::size_t threads = std::thread::hardware_concurrency())
+      : size_(threads > 0 ? threads : 1),
+        queues_(new Queue[size_]),
+        task_(nullptr),
+        pending_(0),
+        active_(0),
+        generation_(0),
+        stop_(false) {
+    for (std::size_t worker = 1; worker < size_; worker++) {
+      workers_.emplace_back([this, worker]() { Work(worker); });
+    }
+  }
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &&worker : workers_) {
+      worker.join();
+    }
+  }
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+  WorkStealingPool(WorkStealingPool &&) = delete;
+  WorkStealingPool &operator=(WorkStealingPool &&) = delete;
+
+  std::size_t Size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * @brief Call task(0) ... task(count - 1) on all threads, return when all finished
+   *
+   * @param count
+   * @param task
+   */
+  void Run(std::size_t count, const std::function<void(std::size_t)> &task) noexcept {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this]() { return active_ == 0; });
+      for (std::size_t worker = 0; worker < size_; worker++) {
+        std::lock_guard<std::mutex> queue_lock(queues_[worker].mutex_);
+        for (std::size_t index = count * worker / size_; index < count * (worker + 1) / size_; index++) {
+          queues_[worker].tasks_.push_back(index);
+        }
+      }
+      task_ = &task;
+      pending_.store(count);
+      generation_++;
+    }
+    wake_.notify_all();
+    Drain(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_.load() == 0; });
+    return;
+  }
+
+ private:
+  typedef struct Queue {
+    std::mutex mutex_;
+    std::deque<std::size_t> tasks_;
+  } Queue;
+
+  void Work(std::size_t worker) noexcept {
+    std::size_t generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this, generation]() { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      active_++;
+      lock.unlock();
+      Drain(worker);
+      lock.lock();
+      active_--;
+      done_.notify_all();
+    }
+  }
+
+  bool Pop(std::size_t worker, std::size_t &index) noexcept {
+    std::lock_guard<std::mutex> lock(queues_[worker].mutex_);
+    if (queues_[worker].tasks_.empty()) {
+      return false;
+    }
+    index = queues_[worker].tasks_.back();
+    queues_[worker].tasks_.pop_back();
+    return true;
+  }
+
+  bool Steal(std::size_t worker, std::size_t &index) noexcept {
+    for (std::size_t offset = 1; offset < size_; offset++) {
+      Queue &victim = queues_[(worker + offset) % size_];
+      std::lock_guard<std::mutex> lock(victim.mutex_);
+      if (!victim.tasks_.empty()) {
+        index = victim.tasks_.front();
+        victim.tasks_.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Drain(std::size_t worker) noexcept {
+    std::size_t index = 0;
+    while (Pop(worker, index) || Steal(worker, index)) {
+      (*task_)(index);
+      if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+      }
+    }
+    return;
+  }
+
+  std::size_t size_;
+  std::unique_ptr<Queue[]> queues_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(std::size_t)> *task_;
+  std::atomic<std::size_t> pending_;
+  std::size_t active_;
+  std::size_t generation_;
+  bool stop_;
+  std::vector<std::thread> workers_;
+};
+
+class Snippet;
+class Block;
+class Class;
+template <typename Node>
+class ConcurrentAppender;
+template <typename Sink>
+class StreamBlock;
+template <typename Sink>
+class StreamClass;
+
+namespace detail {
+
+/**
+ * @brief Indent chain of parents, written before each line of child subtree
+ *
+ * @details
+ * adjacent indents with the same character are merged, so common prefix is a single write.
+ */
+typedef struct Prefix {
+  Prefix(const Prefix *parent, const Indent &indent) noexcept
+      : parent_(parent), width_(indent.Width()), character_(indent.character_) {
+    if (parent_ != nullptr && parent_->character_ == character_) {
+      width_ += parent_->width_;
+      parent_ = parent_->parent_;
+    }
+  }
+
+  const Prefix *parent_;
+  std::size_t width_;
+  char character_;
+
+  template <typename Sink>
+  void IndentTo(Sink &sink) const noexcept {
+    if (parent_ != nullptr) {
+      parent_->IndentTo(sink);
+    }
+    IndentCache::IndentTo(sink, width_, character_);
+    return;
+  }
+
+  std::size_t Width() const noexcept {
+    return width_ + (parent_ != nullptr ? parent_->Width() : 0);
+  }
+
+  /**
+   * @brief Hash of whole chain, equal chains write equal indent
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t Key() const noexcept {
+    const std::uint64_t parent_key = parent_ != nullptr ? parent_->Key() : Hasher::kSeed;
+    const std::uint64_t key = Hasher::Combine(parent_key, static_cast<std::uint64_t>(width_));
+    return Hasher::Combine(key, static_cast<std::uint64_t>(static_cast<unsigned char>(character_)));
+  }
+} Prefix;
+
+/**
+ * @brief Count of newlines inside bytes
+ *
+ * @param data
+ * @param size
+ * @return std::size_t
+ */
+inline std::size_t Breaks(const char *data, std::size_t size) noexcept {
+  std::size_t breaks = 0;
+  const char *end = data + size;
+  while (data < end) {
+    data = static_cast<const char *>(std::memchr(data, '\n', static_cast<std::size_t>(end - data)));
+    if (data == nullptr) {
+      break;
+    }
+    breaks++;
+    data++;
+  }
+  return breaks;
+}
+
+/**
+ * @brief Write bytes, each newline inside is followed by outer prefix
+ *
+ * @param sink
+ * @param data
+ * @param size
+ * @param outer indent of parents, which continued line is written at. nullptr writes bytes as is
+ * @details
+ * same as splitting the line into lines in parent, as Add(any) did.
+ */
+template <typename Sink>
+inline void WriteContinued(Sink &sink, const char *data, std::size_t size, const Prefix *outer) noexcept {
+  const char *end = data + size;
+  while (outer != nullptr && data < end) {
+    const char *line_break = static_cast<const char *>(std::memchr(data, '\n', static_cast<std::size_t>(end - data)));
+    if (line_break == nullptr) {
+      break;
+    }
+    sink.Write(data, static_cast<std::size_t>(line_break + 1 - data));
+    outer->IndentTo(sink);
+    data = line_break + 1;
+  }
+  sink.Write(data, static_cast<std::size_t>(end - data));
+  return;
+}
+
+/**
+ * @brief Fragment of line, formats numbers on stack without allocation
+ *
+ * @details
+ * char is written as character, bool as true/false,
+ * floating point as shortest %g form which reads back to same value.
+ */
+class Piece {
+ public:
+  Piece(const std::string &value) noexcept : external_(value.data()), size_(value.size()) {
+  }
+  Piece(const char *value) noexcept : external_(value), size_(std::strlen(value)) {
+  }
+  Piece(char value) noexcept : external_(nullptr), size_(1) {
+    buffer_[0] = value;
+  }
+  Piece(bool value) noexcept : external_(value ? "true" : "false"), size_(value ? 4 : 5) {
+  }
+  template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value &&
+                                                    !std::is_same<T, bool>::value,
+                                                std::nullptr_t>::type = nullptr>
+  Piece(T value) noexcept : external_(nullptr), size_(0) {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    const bool negative = IsNegative(value, std::is_signed<T>());
+    Unsigned magnitude = static_cast<Unsigned>(value);
+    if (negative) {
+      magnitude = static_cast<Unsigned>(0 - magnitude);
+    }
+    do {
+      buffer_[size_++] = static_cast<char>('0' + magnitude % 10);
+      magnitude = static_cast<Unsigned>(magnitude / 10);
+    } while (magnitude != 0);
+    if (negative) {
+      buffer_[size_++] = '-';
+    }
+    for (std::size_t index = 0; index < size_ / 2; index++) {
+      std::swap(buffer_[index], buffer_[size_ - 1 - index]);
+    }
+  }
+  Piece(float value) noexcept : external_(nullptr), size_(0) {
+    FormatFloating(value);
+  }
+  Piece(double value) noexcept : external_(nullptr), size_(0) {
+    FormatFloating(value);
+  }
+  Piece(long double value) noexcept : external_(nullptr), size_(0) {
+    FormatFloating(value);
+  }
+
+  const char *Data() const noexcept {
+    return external_ != nullptr ? external_ : buffer_;
+  }
+
+  std::size_t Size() const noexcept {
+    return size_;
+  }
+
+ private:
+  template <typename T>
+  static bool IsNegative(T value, std::true_type) noexcept {
+    return value < 0;
+  }
+  template <typename T>
+  static bool IsNegative(T, std::false_type) noexcept {
+    return false;
+  }
+
+  int Print(int precision, double value) noexcept {
+    return std::snprintf(buffer_, sizeof(buffer_), "%.*g", precision, value);
+  }
+  int Print(int precision, long double value) noexcept {
+    return std::snprintf(buffer_, sizeof(buffer_), "%.*Lg", precision, value);
+  }
+
+  template <typename T>
+  void FormatFloating(T value) noexcept {
+    typedef typename std::conditional<std::is_same<T, float>::value, double, T>::type Promoted;
+    for (int precision = std::numeric_limits<T>::digits10; precision <= std::numeric_limits<T>::max_digits10;
+         precision++) {
+      const int written = Print(precision, static_cast<Promoted>(value));
+      size_ = written < 0 ? 0 : static_cast<std::size_t>(written);
+      if (std::equal_to<T>()(static_cast<T>(std::strtold(buffer_, nullptr)), value)) {
+        break;
+      }
+    }
+    return;
+  }
+
+  const char *external_;
+  std::size_t size_;
+  char buffer_[64];
+};
+
+enum class NodeKind { kSnippet, kBlock, kClass, kSpilled };
+
+class ParallelPlan;
+class TreeFile;
+
+/**
+ * @brief Lines and subtrees in order, shared by Snippet, Block contents and Class access sections
+ *
+ * @details
+ * plain line is stored inline as an entry of pointer and length into arena (16 bytes on 64bit) plus its bytes,
+ * subtree is an entry indexing subtrees_.
+ * target is 16 bytes of bookkeeping per line; measured 1M lines of 11 characters into a Class
+ * allocate about 45 bytes per line including vector growth (about 336 bytes with Snippet per line).
+ * structural hash of lines and subtree hashes in order is updated on every add and kept with the entries,
+ * so Hash() of a const body only reads and it is safe to add the same const node from several threads.
+ * entries are copy-on-write: copying a body (and so a node, e.g. Add(const T&)) shares them in constant time,
+ * and the first add into a shared body copies the entries (line bytes stay shared in arena).
+ * a copy never allocates into the arena it shares with the original: its first line goes into a new arena
+ * which keeps the shared one alive, so copies of one node can be added to on different threads.
+ * emplaced subtrees stay mutable through their handle (live), so their hash is taken on every use instead of once.
+ * with SpillFile set, other added subtrees beyond its ceiling are rendered into the file instead of kept.
+ */
+class Body {
+ public:
+  typedef struct Entry {
+    const char *data_;
+    std::size_t size_;
+  } Entry;
+
+  typedef struct Subtree {
+    NodeKind kind_;
+    std::uint64_t hash_;
+    std::shared_ptr<const void> node_;
+    bool live_;
+  } Subtree;
+
+  Body() noexcept {
+  }
+  Body(const Body &other) noexcept
+      : arena_(other.arena_), spill_(other.spill_), storage_(other.storage_), arena_copied_(other.arena_ != nullptr) {
+  }
+  Body &operator=(const Body &other) noexcept {
+    arena_ = other.arena_;
+    spill_ = other.spill_;
+    storage_ = other.storage_;
+    arena_copied_ = other.arena_ != nullptr;
+    return *this;
+  }
+  Body(Body &&) = default;
+  Body &operator=(Body &&) = default;
+
+  static const std::string &None() noexcept {
+    static const std::string none;
+    return none;
+  }
+
+  bool Empty() const noexcept {
+    return Shared().entries_.empty();
+  }
+
+  /**
+   * @brief Structural hash of entries in order
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t Hash() const noexcept {
+    const Storage &storage = Shared();
+    if (storage.live_ > 0) {
+      std::uint64_t hash = Hasher::kSeed;
+      for (const auto &entry : storage.entries_) {
+        hash = Hasher::Fold(hash, entry.data_ != nullptr ? Hasher::Bytes(entry.data_, entry.size_)
+                                                         : SubtreeHash(storage.subtrees_[entry.size_]));
+      }
+      return hash;
+    }
+    return storage.hash_;
+  }
+
+  /**
+   * @brief Hash kept with entries, equal to Hash() unless live, e.g. before and after add for Hasher::Range()
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t Folded() const noexcept {
+    return Shared().hash_;
+  }
+
+  std::size_t Entries() const noexcept {
+    return Shared().entries_.size();
+  }
+
+  /**
+   * @brief Has emplaced subtree, directly or below, which may change after being added
+   *
+   * @return true
+   * @return false
+   */
+  bool Live() const noexcept {
+    return Shared().live_ > 0;
+  }
+
+  /**
+   * @brief Arena to allocate line bytes into, created on first use and after copy
+   *
+   * @return const std::shared_ptr<Arena>&
+   * @details
+   * arena shared with the body this one was copied from is only attached to the new arena, never allocated into.
+   */
+  const std::shared_ptr<Arena> &GetArena() noexcept {
+    if (!arena_ || arena_copied_) {
+      UseArena(std::make_shared<Arena>());
+    }
+    return arena_;
+  }
+
+  /**
+   * @brief Copied from other body and still sharing its arena
+   *
+   * @return true
+   * @return false
+   */
+  bool ArenaCopied() const noexcept {
+    return arena_copied_;
+  }
+
+  /**
+   * @brief Allocate from now on into arena, lines already added stay where they are and old arena is kept alive
+   *
+   * @param arena
+   */
+  void UseArena(const std::shared_ptr<Arena> &arena) noexcept {
+    if (arena != arena_) {
+      arena->Attach(arena_);
+      arena_ = arena;
+    }
+    arena_copied_ = false;
+    return;
+  }
+
+  void SetSpill(const std::shared_ptr<SpillFile> &spill) noexcept {
+    spill_ = spill;
+    return;
+  }
+
+  void SetArena(const std::shared_ptr<Arena> &arena) noexcept {
+    if (!Empty()) {
+      for (auto &&entry : Own().entries_) {
+        if (entry.data_ != nullptr) {
+          char *data = arena->Allocate(entry.size_);
+          std::memcpy(data, entry.data_, entry.size_);
+          entry.data_ = data;
+        }
+      }
+    }
+    arena_ = arena;
+    arena_copied_ = false;
+    return;
+  }
+
+  /**
+   * @brief Append line of bytes already in arena
+   *
+   * @param data
+   * @param size
+   */
+  void PushLine(const char *data, std::size_t size) noexcept {
+    Storage &storage = Own();
+    storage.entries_.push_back({data, size});
+    storage.breaks_ += Breaks(data, size);
+    storage.hash_ = Hasher::Fold(storage.hash_, Hasher::Bytes(data, size));
+    return;
+  }
+
+  void AppendLine(const std::string &header, const char *line, std::size_t size, const std::string &footer) noexcept {
+    const std::size_t total = header.size() + size + footer.size();
+    char *data = GetArena()->Allocate(total);
+    if (total > 0) {  // empty line is the shared empty byte of arena, nothing to copy
+      std::memcpy(data, header.data(), header.size());
+      std::memcpy(data + header.size(), line, size);
+      std::memcpy(data + header.size() + size, footer.data(), footer.size());
+    }
+    PushLine(data, total);
+    return;
+  }
+
+  void Add(const std::string &header, const std::string &line, const std::string &footer) noexcept {
+    AppendLine(header, line.data(), line.size(), footer);
+    return;
+  }
+
+  /**
+   * @brief Add line, large line without header and footer is adopted by arena without copy
+   *
+   */
+  void Add(const std::string &header, std::string &&line, const std::string &footer) noexcept {
+    const std::size_t size = line.size();
+    if (header.empty() && footer.empty() && size >= Arena::kInitialChunkSize) {
+      const char *data = GetArena()->Adopt(std::move(line));
+      PushLine(data, size);
+    } else {
+      AppendLine(header, line.data(), size, footer);
+    }
+    return;
+  }
+
+  void Add(const std::string &header, const char characters[], const std::string &footer) noexcept {
+    AppendLine(header, characters, std::strlen(characters), footer);
+    return;
+  }
+
+  void Add(const std::string &header, const std::vector<std::string> &lines, const std::string &footer) noexcept {
+    for (const auto &line : lines) {
+      Add(header, line, footer);
+    }
+    return;
+  }
+
+  void Add(const std::string &header, std::vector<std::string> &&lines, const std::string &footer) noexcept {
+    for (auto &&line : lines) {
+      Add(header, std::move(line), footer);
+    }
+    return;
+  }
+
+  void Add(const std::string &, const Snippet &snippet, const std::string &) noexcept;
+  void Add(const std::string &, const Block &block, const std::string &) noexcept;
+  void Add(const std::string &, const Class &class_block, const std::string &) noexcept;
+  void Add(const std::string &, Snippet &&snippet, const std::string &) noexcept;
+  void Add(const std::string &, Block &&block, const std::string &) noexcept;
+  void Add(const std::string &, Class &&class_block, const std::string &) noexcept;
+
+  /**
+   * @brief Construct node in place as live subtree sharing arena, returned reference stays valid with the node
+   *
+   * @tparam Node Snippet, Block or Class
+   * @tparam Args
+   * @param args constructor arguments of Node
+   * @return Node&
+   */
+  template <typename Node, typename... Args>
+  Node &Emplace(Args &&...args) noexcept;
+
+  /**
+   * @brief Add any other type snippet as lines
+   *
+   * @tparam T any type with Out()
+   */
+  template <typename T>
+  void Add(const std::string &, const T &any, const std::string &) noexcept {
+    std::stringstream line_stream(any.Out());
+    std::string line;
+    while (std::getline(line_stream, line)) {
+      AppendLine(None(), line.data(), line.size(), None());
+    }
+    return;
+  }
+
+  template <typename... Pieces>
+  void AddLine(const std::string &header, const std::string &footer, const Pieces &...pieces) noexcept {
+    const Piece formatted[] = {pieces...};
+    std::size_t size = 0;
+    for (const auto &piece : formatted) {
+      size += piece.Size();
+    }
+    const std::size_t total = header.size() + size + footer.size();
+    char *const line = GetArena()->Allocate(total);
+    if (total > 0) {  // empty line is the shared empty byte of arena, nothing to copy
+      char *data = line;
+      std::memcpy(data, header.data(), header.size());
+      data += header.size();
+      for (const auto &piece : formatted) {
+        std::memcpy(data, piece.Data(), piece.Size());
+        data += piece.Size();
+      }
+      std::memcpy(data, footer.data(), footer.size());
+    }
+    PushLine(line, total);
+    return;
+  }
+
+  /**
+   * @brief Append entries [first, last) of other body to the end, line bytes and subtrees are shared
+   *
+   * @param other
+   * @param first
+   * @param last
+   * @param range Hasher::Range() of other over the entries, joined to own hash without reading line bytes
+   * @details
+   * caller keeps arena of other alive, e.g. Arena::Attach().
+   */
+  void Append(const Body &other, std::size_t first, std::size_t last, std::uint64_t range) noexcept {
+    const Storage &source = other.Shared();
+    Storage &storage = Own();
+    for (std::size_t index = first; index < last; index++) {
+      const Entry &entry = source.entries_[index];
+      if (entry.data_ != nullptr) {
+        storage.entries_.push_back(entry);
+        storage.breaks_ += source.breaks_ > 0 ? Breaks(entry.data_, entry.size_) : 0;
+      } else {
+        const Subtree &subtree = source.subtrees_[entry.size_];
+        storage.entries_.push_back({nullptr, storage.subtrees_.size()});
+        storage.subtrees_.push_back(subtree);
+        storage.live_ += subtree.live_ ? 1 : 0;
+      }
+    }
+    storage.hash_ = Hasher::Concat(storage.hash_, range, last - first);
+    return;
+  }
+
+  /**
+   * @brief Move all entries of other body to the end and keep its arena alive, line bytes are not copied
+   *
+   * @param other left empty
+   * @details
+   * into empty body the storage itself is moved in constant time,
+   * otherwise entries are appended and hash of other is joined to own hash, line bytes are not read.
+   */
+  void Splice(Body &&other) noexcept {
+    if (!arena_) {
+      arena_ = other.arena_;
+      arena_copied_ = other.arena_copied_;
+    } else if (other.arena_ && other.arena_ != arena_) {
+      GetArena()->Attach(other.arena_);
+    }
+    if (Empty()) {
+      storage_ = std::move(other.storage_);
+    } else {
+      const std::size_t entries = other.Entries();
+      Append(other, 0, entries, Hasher::Range(Hasher::kSeed, other.Folded(), entries));
+    }
+    other.storage_.reset();
+    return;
+  }
+
+  /**
+   * @brief Rendered size
+   *
+   * @param indent_width width of prefix of lines
+   * @param outer_width width of outer prefix after newline inside line
+   * @return std::size_t
+   */
+  std::size_t OutSize(std::size_t indent_width, std::size_t outer_width) const noexcept;
+
+  /**
+   * @brief Render lines and subtrees from first entry, subtrees are looked up in cache unless nullptr
+   *
+   * @details
+   * newline inside line is followed by outer prefix (indent of parents of node), nullptr on top.
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink, const Prefix &prefix, const Prefix *outer, RenderCache *cache, std::size_t first = 0,
+                std::size_t last = std::numeric_limits<std::size_t>::max()) const noexcept;
+
+  /**
+   * @brief Split into segments of about plan grain bytes, subtree larger than grain is split into its own segments
+   *
+   * @param plan
+   * @param prefix kept by plan
+   * @param outer kept by plan
+   */
+  void Plan(ParallelPlan &plan, const Prefix &prefix, const Prefix *outer) const noexcept;
+
+ private:
+  friend class TreeFile;
+
+  typedef struct Storage {
+    Storage() noexcept : live_(0), breaks_(0), hash_(Hasher::kSeed) {
+    }
+    std::vector<Entry> entries_;
+    std::vector<Subtree> subtrees_;
+    std::size_t live_;
+    std::size_t breaks_;  // newlines inside lines
+    std::uint64_t hash_;
+  } Storage;
+
+  const Storage &Shared() const noexcept {
+    static const Storage empty;
+    return storage_ ? *storage_ : empty;
+  }
+
+  /**
+   * @brief Storage to be modified, copied first when shared
+   *
+   * @return Storage&
+   */
+  Storage &Own() noexcept {
+    if (!storage_) {
+      storage_ = std::make_shared<Storage>();
+    } else if (storage_.use_count() > 1) {
+      storage_ = std::make_shared<Storage>(*storage_);
+    }
+    return *storage_;
+  }
+
+  void AddSubtree(NodeKind kind, std::uint64_t hash, std::shared_ptr<const void> &&node, bool live) noexcept {
+    PushSubtree(Own(), {kind, Hasher::Combine(static_cast<std::uint64_t>(kind), hash), std::move(node), live});
+    return;
+  }
+
+  static void PushSubtree(Storage &storage, const Subtree &subtree) noexcept {
+    storage.entries_.push_back({nullptr, storage.subtrees_.size()});
+    storage.subtrees_.push_back(subtree);
+    storage.live_ += subtree.live_ ? 1 : 0;
+    storage.hash_ = Hasher::Fold(storage.hash_, subtree.hash_);
+    return;
+  }
+
+  typedef struct Spilled {
+    std::shared_ptr<SpillFile> file_;
+    SpillFile::Range range_;
+  } Spilled;
+
+  static const std::size_t kSpillReadSize = 16 * 1024;
+
+  /**
+   * @brief Render node into spill file instead of keeping it when over ceiling
+   *
+   * @tparam Node
+   * @param kind
+   * @param node
+   * @return true spilled
+   * @return false to be kept
+   */
+  template <typename Node>
+  bool Spill(NodeKind kind, const Node &node) noexcept;
+
+  template <typename Sink>
+  static void RenderSpilled(Sink &sink, const Spilled &spilled, const Prefix &prefix) noexcept;
+
+  static NodeKind KindOf(const Snippet *) noexcept {
+    return NodeKind::kSnippet;
+  }
+  static NodeKind KindOf(const Block *) noexcept {
+    return NodeKind::kBlock;
+  }
+  static NodeKind KindOf(const Class *) noexcept {
+    return NodeKind::kClass;
+  }
+
+  static std::uint64_t SubtreeHash(const Subtree &subtree) noexcept;
+  static std::size_t SubtreeSize(const Subtree &subtree) noexcept;
+  template <typename Sink>
+  static void RenderSubtree(Sink &sink, const Subtree &subtree, const Prefix &prefix, RenderCache *cache) noexcept;
+  static std::size_t SubtreeOutSize(const Subtree &subtree, std::size_t indent_width) noexcept;
+
+  std::shared_ptr<Arena> arena_;
+  std::shared_ptr<SpillFile> spill_;
+  std::shared_ptr<Storage> storage_;
+  bool arena_copied_ = false;
+};
+
+/**
+ * @brief Rendered bytes of node bodies kept between Out() calls
+ *
+ * @details
+ * added subtrees are immutable copies and bodies only grow, so an entry count per body marks what is clean;
+ * only entries added since last render are rendered and appended. changed key (indent) drops everything,
+ * body with live (emplaced) subtrees is rendered again every time. copies start empty.
+ */
+class OutCache {
+ public:
+  OutCache() noexcept : enabled_(false), key_(0) {
+  }
+  ~OutCache() = default;
+  OutCache(const OutCache &other) noexcept : enabled_(other.enabled_), key_(0) {
+  }
+  OutCache &operator=(const OutCache &other) noexcept {
+    enabled_ = other.enabled_;
+    parts_.clear();
+    return *this;
+  }
+  OutCache(OutCache &&) = default;
+  OutCache &operator=(OutCache &&) = default;
+
+  bool Enabled() const noexcept {
+    return enabled_;
+  }
+
+  void Enable(bool enable) noexcept {
+    enabled_ = enable;
+    parts_.clear();
+    return;
+  }
+
+  /**
+   * @brief Drop rendered bytes of bodies which were emptied, e.g. spliced into other node
+   *
+   */
+  void Clear() noexcept {
+    parts_.clear();
+    return;
+  }
+
+  /**
+   * @brief Rendered bytes of body, updated with entries added since last call
+   *
+   * @param index body index of node
+   * @param key
+   * @param body
+   * @param prefix
+   * @return const std::string&
+   */
+  const std::string &Render(std::size_t index, std::uint64_t key, const Body &body, const Prefix &prefix) noexcept {
+    if (key != key_) {
+      parts_.clear();
+      key_ = key;
+    }
+    if (parts_.size() <= index) {
+      parts_.resize(index + 1);
+    }
+    Part &part = parts_[index];
+    if (body.Live()) {
+      part.bytes_.clear();
+      part.entries_ = 0;
+    }
+    if (part.entries_ < body.Entries()) {
+      StringSink sink(part.bytes_);
+      body.RenderTo(sink, prefix, nullptr, nullptr, part.entries_);
+      part.entries_ = body.Entries();
+    }
+    return part.bytes_;
+  }
+
+ private:
+  typedef struct Part {
+    Part() noexcept : entries_(0) {
+    }
+    std::string bytes_;
+    std::size_t entries_;
+  } Part;
+
+  bool enabled_;
+  std::uint64_t key_;
+  std::vector<Part> parts_;
+};
+
+/**
+ * @brief Segments of output with exact sizes, rendered at prefix-summed offsets of one buffer in parallel
+ *
+ */
+class ParallelPlan {
+ public:
+  static const std::size_t kDefaultGrain = 256 * 1024;
+
+  typedef struct Segment {
+    std::size_t size_;
+    std::function<void(BufferSink &)> write_;
+  } Segment;
+
+  explicit ParallelPlan(std::size_t grain) noexcept : grain_(grain > 0 ? grain : 1) {
+  }
+
+  std::size_t Grain() const noexcept {
+    return grain_;
+  }
+
+  /**
+   * @brief Keep prefix alive until rendered
+   *
+   * @param prefix
+   * @return const Prefix*
+   */
+  const Prefix *Keep(const Prefix &prefix) noexcept {
+    prefixes_.push_back(prefix);
+    return &prefixes_.back();
+  }
+
+  void Add(std::size_t size, std::function<void(BufferSink &)> &&write) noexcept {
+    segments_.push_back({size, std::move(write)});
+    return;
+  }
+
+  template <typename Executor>
+  std::string Run(Executor &executor) const noexcept {
+    std::vector<std::size_t> offsets(segments_.size() + 1, 0);
+    for (std::size_t index = 0; index < segments_.size(); index++) {
+      offsets[index + 1] = offsets[index] + segments_[index].size_;
+    }
+    std::string out(offsets.back(), '\0');
+    char *const buffer = &out[0];
+    executor.Run(segments_.size(), [this, buffer, &offsets](std::size_t index) {
+      BufferSink sink(buffer + offsets[index]);
+      segments_[index].write_(sink);
+    });
+    return out;
+  }
+
+ private:
+  std::size_t grain_;
+  std::deque<Prefix> prefixes_;
+  std::vector<Segment> segments_;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Snippet
+ *
+ */
+class Snippet {
+ public:
+  /**
+   * @brief Construct a new Snippet object as default : Line
+   *
+   * @param indent
+   */
+  Snippet(const Indent &indent = Indent(0, kDefaultIndentSize)) : Snippet(LineType(), indent) {
+  }
+  /**
+   * @brief Construct a new Snippet object as Line
+   *
+   * @param indent
+   */
+  Snippet(LineType, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), header_(), footer_(), type_(Type::kLine) {
+  }
+  /**
+   * @brief Construct a new Snippet object as system include
+   *
+   * @param indent
+   */
+  Snippet(SystemIncludeType, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), header_("#include <"), footer_(">"), type_(Type::kSystemInclude) {
+  }
+  /**
+   * @brief Construct a new Snippet object as local include
+   *
+   * @param base_dir_path include relative base path
+   * @param indent
+   */
+  Snippet(LocalIncludeType, const std::string base_dir_path, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), header_("#include \"" + base_dir_path), footer_("\""), type_(Type::kLocalInclude) {
+  }
+  ~Snippet() = default;
+  Snippet(const Snippet &) = default;
+  Snippet &operator=(const Snippet &) = default;
+  Snippet(Snippet &&) = default;
+  Snippet &operator=(Snippet &&) = default;
+
+  /**
+   * @brief Out with own indent
+   *
+   * @return std::string
+   */
+  std::string Out() const noexcept {
+    if (out_cache_.Enabled()) {
+      return CachedBody();
+    }
+    std::string snippet(OutSize(), '\0');
+    BufferSink sink(&snippet[0]);
+    RenderTo(sink);
+    return snippet;
+  }
+
+  /**
+   * @brief Exact byte size of Out()
+   *
+   * @return std::size_t
+   */
+  std::size_t OutSize() const noexcept {
+    return OutSize(0);
+  }
+
+  /**
+   * @brief Render with own indent into sink
+   *
+   * @tparam Sink any type with Write(const char *, std::size_t)
+   * @param sink
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink) const noexcept {
+    if (out_cache_.Enabled()) {
+      const std::string &rendered = CachedBody();
+      sink.Write(rendered.data(), rendered.size());
+      return;
+    }
+    RenderTo(sink, nullptr, nullptr);
+    return;
+  }
+
+  /**
+   * @brief Render into sink, identical subtrees are rendered once and copied from cache
+   *
+   * @tparam Sink any type with Write(const char *, std::size_t)
+   * @param sink
+   * @param cache
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink, RenderCache &cache) const noexcept {
+    RenderTo(sink, nullptr, &cache);
+    return;
+  }
+
+  /**
+   * @brief Out with own indent, identical subtrees are rendered once and copied from cache
+   *
+   * @param cache
+   * @return std::string
+   */
+  std::string Out(RenderCache &cache) const noexcept {
+    std::string out;
+    StringSink sink(out);
+    RenderTo(sink, nullptr, &cache);
+    return out;
+  }
+
+  /**
+   * @brief Out rendered by executor threads, same bytes as Out()
+   *
+   * @tparam Executor any type with Run(std::size_t count, const std::function<void(std::size_t)> &task)
+   * @param executor e.g. ThreadPool
+   * @param grain approximate bytes rendered by one task
+   * @return std::string
+   * @details
+   * sizes of children give offsets into one preallocated buffer, tasks fill their ranges concurrently.
+   */
+  template <typename Executor>
+  std::string ParallelOut(Executor &executor, std::size_t grain = detail::ParallelPlan::kDefaultGrain) const noexcept {
+    detail::ParallelPlan plan(grain);
+    Plan(plan, nullptr);
+    return plan.Run(executor);
+  }
+
+  /**
+   * @brief Structural hash of contents and indent, equal for trees rendering equal output
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t Hash() const noexcept {
+    std::uint64_t hash = detail::Hasher::Combine(detail::Hasher::kSeed, indent_);
+    return detail::Hasher::Combine(hash, body_.Hash());
+  }
+
+  /**
+   * @brief Keep rendered output, later Out() and RenderTo() render only lines and subtrees added since
+   *
+   * @param enable
+   * @details
+   * IncrementIndent() renders all again. copies start with empty cache. Out() is not thread-safe while enabled.
+   */
+  void CacheOut(bool enable = true) noexcept {
+    out_cache_.Enable(enable);
+    return;
+  }
+
+  Type GetType() const noexcept {
+    return type_;
+  }
+
+  void Add(const std::string &line) noexcept {
+    body_.Add(header_, line, footer_);
+    return;
+  }
+
+  /**
+   * @brief Add line, large line without header and footer is adopted by arena without copy
+   *
+   * @param line
+   */
+  void Add(std::string &&line) noexcept {
+    body_.Add(header_, std::move(line), footer_);
+    return;
+  }
+
+  /**
+   * @brief Add snippet, block and class as subtree, rendered once with own indent on Out()
+   *
+   * @param snippet
+   */
+  void Add(const Snippet &snippet) noexcept {
+    body_.Add(header_, snippet, footer_);
+    return;
+  }
+  void Add(const Block &block) noexcept {
+    body_.Add(header_, block, footer_);
+    return;
+  }
+  void Add(const Class &class_block) noexcept {
+    body_.Add(header_, class_block, footer_);
+    return;
+  }
+  /**
+   * @brief Add snippet, block and class as subtree by moving, without copy of lines and children
+   *
+   * @param snippet
+   */
+  void Add(Snippet &&snippet) noexcept {
+    body_.Add(header_, std::move(snippet), footer_);
+    return;
+  }
+  void Add(Block &&block) noexcept {
+    body_.Add(header_, std::move(block), footer_);
+    return;
+  }
+  void Add(Class &&class_block) noexcept {
+    body_.Add(header_, std::move(class_block), footer_);
+    return;
+  }
+
+  /**
+   * @brief Add any other type snippet as lines
+   *
+   * @tparam T any type with Out()
+   * @param any
+   */
+  template <typename T>
+  void Add(const T &any) noexcept {
+    body_.Add(header_, any, footer_);
+    return;
+  }
+  void Add(const char characters[]) noexcept {
+    body_.Add(header_, characters, footer_);
+    return;
+  }
+
+  void Add(const std::vector<std::string> &lines) noexcept {
+    body_.Add(header_, lines, footer_);
+    return;
+  }
+
+  void Add(std::vector<std::string> &&lines) noexcept {
+    body_.Add(header_, std::move(lines), footer_);
+    return;
+  }
+
+  /**
+   * @brief Add one line built from pieces, same as AddLine()
+   *
+   * @tparam Pieces
+   * @param first
+   * @param second
+   * @param rest
+   */
+  template <typename First, typename Second, typename... Pieces>
+  void Add(const First &first, const Second &second, const Pieces &...rest) noexcept {
+    AddLine(first, second, rest...);
+    return;
+  }
+
+  /**
+   * @brief Add one line built from strings, characters, integers and floating points
+   *
+   * @tparam Pieces
+   * @param pieces
+   * @details
+   * total length is computed once and the line is written into arena with single allocation, or none.
+   */
+  template <typename... Pieces>
+  void AddLine(const Pieces &...pieces) noexcept {
+    body_.AddLine(header_, footer_, pieces...);
+    return;
+  }
+
+  /**
+   * @brief Move lines and subtrees of other snippet to the end, as built by another thread
+   *
+   * @param other left empty
+   * @details
+   * line bytes are not copied, arena of other is kept alive by own arena.
+   */
+  void Splice(Snippet &&other) noexcept {
+    body_.Splice(std::move(other.body_));
+    other.out_cache_.Clear();
+    return;
+  }
+
+  void IncrementIndent(std::size_t level = 1) noexcept {
+    indent_.level_ += level;
+    return;
+  }
+
+  /**
+   * @brief Arena holding line bytes, created on first use unless set
+   *
+   * @return const std::shared_ptr<Arena>&
+   */
+  const std::shared_ptr<Arena> &GetArena() noexcept {
+    return body_.GetArena();
+  }
+
+  /**
+   * @brief Store line bytes into arena, e.g. one arena shared by whole document
+   *
+   * @param arena
+   * @details
+   * lines already added are copied into new arena.
+   */
+  void SetArena(const std::shared_ptr<Arena> &arena) noexcept {
+    body_.SetArena(arena);
+    return;
+  }
+
+  /**
+   * @brief Spill subtrees added from now on into file when its ceiling is reached, output is unchanged
+   *
+   * @param spill shared by nodes of one document
+   * @details
+   * emplaced subtrees, and nodes holding them, are not spilled.
+   */
+  void SetSpill(const std::shared_ptr<SpillFile> &spill) noexcept {
+    body_.SetSpill(spill);
+    return;
+  }
+
+ private:
+  friend class detail::Body;
+  friend class detail::TreeFile;
+  template <typename Sink>
+  friend class StreamBlock;
+  template <typename Sink>
+  friend class StreamClass;
+
+  std::size_t OutSize(std::size_t prefix_width) const noexcept {
+    return body_.OutSize(prefix_width + indent_.Width(), prefix_width);
+  }
+
+  bool Live() const noexcept {
+    return body_.Live();
+  }
+
+  template <typename Sink>
+  void RenderTo(Sink &sink, const detail::Prefix *prefix, RenderCache *cache) const noexcept {
+    body_.RenderTo(sink, detail::Prefix(prefix, indent_), prefix, cache);
+    return;
+  }
+
+  void Plan(detail::ParallelPlan &plan, const detail::Prefix *prefix) const noexcept {
+    body_.Plan(plan, *plan.Keep(detail::Prefix(prefix, indent_)), prefix);
+    return;
+  }
+
+  const std::string &CachedBody() const noexcept {
+    return out_cache_.Render(0, detail::Hasher::Combine(detail::Hasher::kSeed, indent_), body_,
+                             detail::Prefix(nullptr, indent_));
+  }
+
+  Indent indent_;
+  std::string header_;
+  std::string footer_;
+  Type type_;
+  detail::Body body_;
+  mutable detail::OutCache out_cache_;
+};
+
+/**
+ * @brief Codeblock
+ *
+ */
+class Block {
+ public:
+  /**
+   * @brief Construct a new Block object as default : codeblock
+   *
+   * @param indent
+   */
+  Block(const Indent &indent = Indent(0, kDefaultIndentSize)) : Block(CodeBlockType(), indent) {
+  }
+  /**
+   * @brief Construct a new Block object as codeblock
+   *
+   * @param indent
+   */
+  Block(CodeBlockType, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), header_("{\n"), type_(Type::kCodeBlock) {
+  }
+  /**
+   * @brief Construct a new Block object as definition
+   *
+   * @param indent
+   */
+  Block(DefinitionType, const std::string &declaration, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), header_(declaration + " {\n"), type_(Type::kDefinition) {
+  }
+  /**
+   * @brief Construct a new Block object as namespace
+   *
+   * @param name
+   * @param indent
+   */
+  Block(NamespaceType, const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), header_("namespace " + name + " {\n"), type_(Type::kNamespace) {
+  }
+  ~Block() = default;
+  Block(const Block &) = default;
+  Block &operator=(const Block &) = default;
+  Block(Block &&) = default;
+  Block &operator=(Block &&) = default;
+
+  /**
+   * @brief Out with own indent
+   *
+   * @return std::string
+   */
+  std::string Out() const noexcept {
+    if (out_cache_.Enabled()) {
+      std::string out;
+      StringSink sink(out);
+      RenderCachedTo(sink);
+      return out;
+    }
+    std::string block(OutSize(), '\0');
+    BufferSink sink(&block[0]);
+    RenderTo(sink);
+    return block;
+  }
+
+  /**
+   * @brief Exact byte size of Out()
+   *
+   * @return std::size_t
+   */
+  std::size_t OutSize() const noexcept {
+    return OutSize(0);
+  }
+
+  /**
+   * @brief Render with own indent into sink
+   *
+   * @tparam Sink any type with Write(const char *, std::size_t)
+   * @param sink
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink) const noexcept {
+    if (out_cache_.Enabled()) {
+      RenderCachedTo(sink);
+      return;
+    }
+    RenderTo(sink, nullptr, nullptr);
+    return;
+  }
+
+  /**
+   * @brief Render into sink, identical subtrees are rendered once and copied from cache
+   *
+   * @tparam Sink any type with Write(const char *, std::size_t)
+   * @param sink
+   * @param cache
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink, RenderCache &cache) const noexcept {
+    RenderTo(sink, nullptr, &cache);
+    return;
+  }
+
+  /**
+   * @brief Out with own indent, identical subtrees are rendered once and copied from cache
+   *
+   * @param cache
+   * @return std::string
+   */
+  std::string Out(RenderCache &cache) const noexcept {
+    std::string out;
+    StringSink sink(out);
+    RenderTo(sink, nullptr, &cache);
+    return out;
+  }
+
+  /**
+   * @brief Out rendered by executor threads, same bytes as Out()
+   *
+   * @tparam Executor any type with Run(std::size_t count, const std::function<void(std::size_t)> &task)
+   * @param executor e.g. ThreadPool
+   * @param grain approximate bytes rendered by one task
+   * @return std::string
+   * @details
+   * sizes of children give offsets into one preallocated buffer, tasks fill their ranges concurrently.
+   */
+  template <typename Executor>
+  std::string ParallelOut(Executor &executor, std::size_t grain = detail::ParallelPlan::kDefaultGrain) const noexcept {
+    detail::ParallelPlan plan(grain);
+    Plan(plan, nullptr);
+    return plan.Run(executor);
+  }
+
+  /**
+   * @brief Structural hash of contents and indent, equal for trees rendering equal output
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t Hash() const noexcept {
+    std::uint64_t hash = detail::Hasher::Combine(detail::Hasher::kSeed, indent_);
+    hash = detail::Hasher::Combine(hash, header_);
+    return detail::Hasher::Combine(hash, body_.Hash());
+  }
+
+  /**
+   * @brief Keep rendered output, later Out() and RenderTo() render only lines and subtrees added since
+   *
+   * @param enable
+   * @details
+   * IncrementIndent() renders all again. copies start with empty cache. Out() is not thread-safe while enabled.
+   */
+  void CacheOut(bool enable = true) noexcept {
+    out_cache_.Enable(enable);
+    return;
+  }
+
+  Type GetType() const noexcept {
+    return type_;
+  }
+
+  void Add(const std::vector<std::string> &lines) noexcept {
+    body_.Add(detail::Body::None(), lines, detail::Body::None());
+    return;
+  }
+
+  void Add(std::vector<std::string> &&lines) noexcept {
+    body_.Add(detail::Body::None(), std::move(lines), detail::Body::None());
+    return;
+  }
+
+  /**
+   * @brief Add any type snippet one level deeper than block, rvalue is moved
+   *
+   * @tparam T
+   * @param any
+   */
+  template <typename T>
+  void Add(T &&any) noexcept {
+    body_.Add(detail::Body::None(), std::forward<T>(any), detail::Body::None());
+    return;
+  }
+
+  /**
+   * @brief Add one line built from pieces, same as AddLine()
+   *
+   * @tparam Pieces
+   * @param first
+   * @param second
+   * @param rest
+   */
+  template <typename First, typename Second, typename... Pieces>
+  void Add(const First &first, const Second &second, const Pieces &...rest) noexcept {
+    AddLine(first, second, rest...);
+    return;
+  }
+
+  /**
+   * @brief Add one line built from strings, characters, integers and floating points
+   *
+   * @tparam Pieces
+   * @param pieces
+   */
+  template <typename... Pieces>
+  void AddLine(const Pieces &...pieces) noexcept {
+    body_.AddLine(detail::Body::None(), detail::Body::None(), pieces...);
+    return;
+  }
+
+  /**
+   * @brief Move contents of other block to the end, as built by another thread; header of other is dropped
+   *
+   * @param other left empty
+   * @details
+   * line bytes are not copied, arena of other is kept alive by own arena.
+   */
+  void Splice(Block &&other) noexcept {
+    body_.Splice(std::move(other.body_));
+    other.out_cache_.Clear();
+    return;
+  }
+
+  /**
+   * @brief Construct child block, class or snippet in place and return it to be filled later, in any order
+   *
+   * @tparam Node Snippet, Block or Class
+   * @tparam Args
+   * @param args constructor arguments of Node
+   * @return Node& valid while this block, a copy or a node it was added to is alive
+   * @details
+   * child is not copied and shares arena. copies of this block share the child, so later changes show in each.
+   * outputs of this block and its parents are hashed and cached again on every use while it holds such a child.
+   */
+  template <typename Node, typename... Args>
+  Node &Emplace(Args &&...args) noexcept {
+    return body_.Emplace<Node>(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Increment own indent, contents follow relatively in constant time
+   *
+   * @param level
+   */
+  void IncrementIndent(std::size_t level = 1) noexcept {
+    indent_.level_ += level;
+    return;
+  }
+
+  /**
+   * @brief Arena holding line bytes, created on first use unless set
+   *
+   * @return const std::shared_ptr<Arena>&
+   */
+  const std::shared_ptr<Arena> &GetArena() noexcept {
+    return body_.GetArena();
+  }
+
+  /**
+   * @brief Store line bytes into arena, e.g. one arena shared by whole document
+   *
+   * @param arena
+   * @details
+   * lines already added are copied into new arena.
+   */
+  void SetArena(const std::shared_ptr<Arena> &arena) noexcept {
+    body_.SetArena(arena);
+    return;
+  }
+
+  /**
+   * @brief Spill subtrees added from now on into file when its ceiling is reached, output is unchanged
+   *
+   * @param spill shared by nodes of one document
+   * @details
+   * emplaced subtrees, and nodes holding them, are not spilled.
+   */
+  void SetSpill(const std::shared_ptr<SpillFile> &spill) noexcept {
+    body_.SetSpill(spill);
+    return;
+  }
+
+ private:
+  friend class detail::Body;
+  friend class detail::TreeFile;
+  template <typename Node>
+  friend class ConcurrentAppender;
+  template <typename Sink>
+  friend class StreamBlock;
+  template <typename Sink>
+  friend class StreamClass;
+
+  static const std::size_t kFooterSize = 2;
+  static const char *Footer() noexcept {
+    return "}\n";
+  }
+
+  /**
+   * @brief Indent of contents, one level deeper in spaces whatever character own indent is
+   *
+   * @return Indent
+   */
+  Indent ContentIndent() const noexcept {
+    return Indent(indent_.level_ + 1, indent_.size_);
+  }
+
+  std::size_t OutSize(std::size_t prefix_width) const noexcept {
+    const std::size_t indent_width = prefix_width + indent_.Width();
+    return indent_width * 2 + HeaderSize(prefix_width) + kFooterSize +
+           body_.OutSize(indent_width + indent_.size_, prefix_width);
+  }
+
+  /**
+   * @brief Size of header, continued at prefix after each newline inside declaration
+   *
+   * @param prefix_width
+   * @return std::size_t
+   */
+  std::size_t HeaderSize(std::size_t prefix_width) const noexcept {
+    return header_.size() + detail::Breaks(header_.data(), header_.size() - 1) * prefix_width;
+  }
+
+  template <typename Sink>
+  void HeaderTo(Sink &sink, const detail::Prefix *prefix) const noexcept {
+    detail::WriteContinued(sink, header_.data(), header_.size() - 1, prefix);
+    sink.Write("\n", 1);
+    return;
+  }
+
+  bool Live() const noexcept {
+    return body_.Live();
+  }
+
+  template <typename Sink>
+  void RenderTo(Sink &sink, const detail::Prefix *prefix, RenderCache *cache) const noexcept {
+    const detail::Prefix own_prefix(prefix, indent_);
+    own_prefix.IndentTo(sink);
+    HeaderTo(sink, prefix);
+    body_.RenderTo(sink, detail::Prefix(prefix, ContentIndent()), prefix, cache);
+    own_prefix.IndentTo(sink);
+    sink.Write(Footer(), kFooterSize);
+    return;
+  }
+
+  void Plan(detail::ParallelPlan &plan, const detail::Prefix *prefix) const noexcept {
+    const detail::Prefix *own_prefix = plan.Keep(detail::Prefix(prefix, indent_));
+    const std::size_t indent_width = own_prefix->Width();
+    plan.Add(indent_width + HeaderSize(prefix != nullptr ? prefix->Width() : 0),
+             [this, prefix, own_prefix](BufferSink &sink) {
+               own_prefix->IndentTo(sink);
+               HeaderTo(sink, prefix);
+             });
+    body_.Plan(plan, *plan.Keep(detail::Prefix(prefix, ContentIndent())), prefix);
+    plan.Add(indent_width + kFooterSize, [own_prefix](BufferSink &sink) {
+      own_prefix->IndentTo(sink);
+      sink.Write(Footer(), kFooterSize);
+    });
+    return;
+  }
+
+  template <typename Sink>
+  void RenderCachedTo(Sink &sink) const noexcept {
+    const detail::Prefix own_prefix(nullptr, indent_);
+    const std::string &rendered =
+        out_cache_.Render(0, detail::Hasher::Combine(detail::Hasher::kSeed, indent_), body_,
+                          detail::Prefix(nullptr, ContentIndent()));
+    own_prefix.IndentTo(sink);
+    sink.Write(header_.data(), header_.size());
+    sink.Write(rendered.data(), rendered.size());
+    own_prefix.IndentTo(sink);
+    sink.Write(Footer(), kFooterSize);
+    return;
+  }
+
+  detail::Body &AppendTarget() noexcept {
+    return body_;
+  }
+
+  Indent indent_;
+  std::string header_;
+  Type type_;
+  detail::Body body_;
+  mutable detail::OutCache out_cache_;
+};
+
+/**
+ * @brief Class and Struct
+ *
+ */
+class Class {
+ public:
+  /**
+   * @brief Construct a new Class object default : class
+   *
+   * @param name
+   * @param indent
+   */
+  Class(const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : Class(ClassType(), name, indent) {
+  }
+  /**
+   * @brief Construct a new Class object as class
+   *
+   * @param name
+   * @param indent
+   * @details
+   * default access specifier is private.
+   */
+  Class(ClassType, const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), name_(name), header_(" {\n"), type_(Type::kClass), now_specifier_(AccessSpecifier::kPrivate) {
+  }
+  /**
+   * @brief Construct a new Class object as class with inheritances
+   *
+   * @param name
+   * @param inheritances inheritance access specifiers and class names
+   * @param indent
+   */
+  Class(ClassType, const std::string &name, const std::vector<std::pair<AccessSpecifier, std::string>> inheritances,
+        const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), name_(name), header_(" {\n"), type_(Type::kClass), now_specifier_(AccessSpecifier::kPrivate) {
+    for (const auto &inheritance : inheritances) {
+      AddInheritance(inheritance.second, inheritance.first);
+    }
+  }
+  /**
+   * @brief Construct a new Class object as struct
+   *
+   * @param name
+   * @param indent
+   * @details
+   * default access specifier is public.
+   */
+  Class(StructType, const std::string &name, const Indent &indent = Indent(0, kDefaultIndentSize))
+      : indent_(indent), name_(name), header_(" {\n"), type_(Type::kStruct), now_specifier_(AccessSpecifier::kPublic) {
+  }
+  ~Class() = default;
+  Class(const Class &) = default;
+  Class &operator=(const Class &) = default;
+  Class(Class &&) = default;
+  Class &operator=(Class &&) = default;
+
+  /**
+   * @brief Out with own indent
+   *
+   * @return std::string
+   */
+  std::string Out() const noexcept {
+    if (out_cache_.Enabled()) {
+      std::string out;
+      StringSink sink(out);
+      RenderCachedTo(sink);
+      return out;
+    }
+    std::string block(OutSize(), '\0');
+    BufferSink sink(&block[0]);
+    RenderTo(sink);
+    return block;
+  }
+
+  /**
+   * @brief Exact byte size of Out()
+   *
+   * @return std::size_t
+   */
+  std::size_t OutSize() const noexcept {
+    return OutSize(0);
+  }
+
+  /**
+   * @brief Render with own indent into sink
+   *
+   * @tparam Sink any type with Write(const char *, std::size_t)
+   * @param sink
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink) const noexcept {
+    if (out_cache_.Enabled()) {
+      RenderCachedTo(sink);
+      return;
+    }
+    RenderTo(sink, nullptr, nullptr);
+    return;
+  }
+
+  /**
+   * @brief Render into sink, identical subtrees are rendered once and copied from cache
+   *
+   * @tparam Sink any type with Write(const char *, std::size_t)
+   * @param sink
+   * @param cache
+   */
+  template <typename Sink>
+  void RenderTo(Sink &sink, RenderCache &cache) const noexcept {
+    RenderTo(sink, nullptr, &cache);
+    return;
+  }
+
+  /**
+   * @brief Out with own indent, identical subtrees are rendered once and copied from cache
+   *
+   * @param cache
+   * @return std::string
+   */
+  std::string Out(RenderCache &cache) const noexcept {
+    std::string out;
+    StringSink sink(out);
+    RenderTo(sink, nullptr, &cache);
+    return out;
+  }
+
+  /**
+   * @brief Out rendered by executor threads, same bytes as Out()
+   *
+   * @tparam Executor any type with Run(std::size_t count, const std::function<void(std::size_t)> &task)
+   * @param executor e.g. ThreadPool
+   * @param grain approximate bytes rendered by one task
+   * @return std::string
+   * @details
+   * sizes of children give offsets into one preallocated buffer, tasks fill their ranges concurrently.
+   */
+  template <typename Executor>
+  std::string ParallelOut(Executor &executor, std::size_t grain = detail::ParallelPlan::kDefaultGrain) const noexcept {
+    detail::ParallelPlan plan(grain);
+    Plan(plan, nullptr);
+    return plan.Run(executor);
+  }
+
+  /**
+   * @brief Structural hash of contents and indent, equal for trees rendering equal output
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t Hash() const noexcept {
+    std::uint64_t hash = detail::Hasher::Combine(detail::Hasher::kSeed, indent_);
+    hash = detail::Hasher::Combine(hash, name_);
+    hash = detail::Hasher::Combine(hash, header_);
+    for (const auto &section : sections_) {
+      hash = detail::Hasher::Combine(hash, section.Hash());
+    }
+    return hash;
+  }
+
+  /**
+   * @brief Keep rendered output, later Out() and RenderTo() render only lines and subtrees added since
+   *
+   * @param enable
+   * @details
+   * IncrementIndent() renders all again. copies start with empty cache. Out() is not thread-safe while enabled.
+   */
+  void CacheOut(bool enable = true) noexcept {
+    out_cache_.Enable(enable);
+    return;
+  }
+
+  Type GetType() const noexcept {
+    return type_;
+  }
+
+  void Add(const std::vector<std::string> &lines) noexcept {
+    Section().Add(detail::Body::None(), lines, detail::Body::None());
+    return;
+  }
+
+  void Add(std::vector<std::string> &&lines) noexcept {
+    Section().Add(detail::Body::None(), std::move(lines), detail::Body::None());
+    return;
+  }
+
+  /**
+   * @brief Add any type snippet one level deeper than class into current access specifier, rvalue is moved
+   *
+   * @tparam T
+   * @param any
+   */
+  template <typename T>
+  void Add(T &&any) noexcept {
+    Section().Add(detail::Body::None(), std::forward<T>(any), detail::Body::None());
+    return;
+  }
+
+  /**
+   * @brief Add one line built from pieces, same as AddLine()
+   *
+   * @tparam Pieces
+   * @param first
+   * @param second
+   * @param rest
+   */
+  template <typename First, typename Second, typename... Pieces>
+  void Add(const First &first, const Second &second, const Pieces &...rest) noexcept {
+    AddLine(first, second, rest...);
+    return;
+  }
+
+  /**
+   * @brief Add one line built from strings, characters, integers and floating points into current access specifier
+   *
+   * @tparam Pieces
+   * @param pieces
+   */
+  template <typename... Pieces>
+  void AddLine(const Pieces &...pieces) noexcept {
+    Section().AddLine(detail::Body::None(), detail::Body::None(), pieces...);
+    return;
+  }
+
+  /**
+   * @brief Increment own indent, contents follow relatively in constant time
+   *
+   * @param level
+   */
+  void IncrementIndent(std::size_t level = 1) noexcept {
+    indent_.level_ += level;
+    return;
+  }
+
+  /**
+   * @brief Move contents of every access specifier of other class to the end of the same access specifier
+   *
+   * @param other left empty
+   * @details
+   * line bytes are not copied, arena of other is kept alive by own arena.
+   */
+  void Splice(Class &&other) noexcept {
+    GetArena();
+    for (std::size_t index = 0; index < sections_.size(); index++) {
+      sections_[index].Splice(std::move(other.sections_[index]));
+    }
+    other.out_cache_.Clear();
+    return;
+  }
+
+  /**
+   * @brief Construct member block, nested class or snippet in place into current access specifier, same as
+   * Block::Emplace()
+   *
+   * @tparam Node Snippet, Block or Class
+   * @tparam Args
+   * @param args constructor arguments of Node
+   * @return Node& valid while this class, a copy or a node it was added to is alive
+   */
+  template <typename Node, typename... Args>
+  Node &Emplace(Args &&...args) noexcept {
+    return Section().Emplace<Node>(std::forward<Args>(args)...);
+  }
+
+  void AddInheritance(const std::string &name, AccessSpecifier access_specifier = AccessSpecifier::kPublic) noexcept {
+    std::string access_specifier_str;
+    if (access_specifier == AccessSpecifier::kPublic) {
+      access_specifier_str = "public";
+    } else if (access_specifier == AccessSpecifier::kProtected) {
+      access_specifier_str = "protected";
+    } else if (access_specifier == AccessSpecifier::kPrivate) {
+      access_specifier_str = "private";
+    }
+    if (header_.size() < 3 || header_.substr(0, 3) != " : ") {
+      header_.insert(0, " : ");
+      header_.insert(header_.size() - 3, access_specifier_str + " " + name);
+    } else {
+      header_.insert(header_.size() - 3, ", " + access_specifier_str + " " + name);
+    }
+    return;
+  }
+
+  void SetAccessSpecifier(AccessSpecifier access_specifier) {
+    now_specifier_ = access_specifier;
+  }
+
+  /**
+   * @brief Arena holding line bytes of all access specifiers, created on first use unless set
+   *
+   * @return const std::shared_ptr<Arena>&
+   */
+  const std::shared_ptr<Arena> &GetArena() noexcept {
+    if (!arena_ || sections_[0].ArenaCopied()) {
+      std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+      arena->Attach(arena_);
+      for (auto &&section : sections_) {
+        section.UseArena(arena);
+      }
+      arena_ = std::move(arena);
+    }
+    return arena_;
+  }
+
+  /**
+   * @brief Store line bytes into arena, e.g. one arena shared by whole document
+   *
+   * @param arena
+   * @details
+   * lines already added are copied into new arena.
+   */
+  void SetArena(const std::shared_ptr<Arena> &arena) noexcept {
+    for (auto &&section : sections_) {
+      section.SetArena(arena);
+    }
+    arena_ = arena;
+    return;
+  }
+
+  /**
+   * @brief Spill subtrees added from now on into file when its ceiling is reached, same as Block::SetSpill()
+   *
+   * @param spill
+   */
+  void SetSpill(const std::shared_ptr<SpillFile> &spill) noexcept {
+    for (auto &&section : sections_) {
+      section.SetSpill(spill);
+    }
+    return;
+  }
+
+ private:
+  friend class detail::Body;
+  friend class detail::TreeFile;
+  template <typename Node>
+  friend class ConcurrentAppender;
+  template <typename Sink>
+  friend class StreamBlock;
+  template <typename Sink>
+  friend class StreamClass;
+
+  static const std::size_t kFooterSize = 3;
+  static const char *Footer() noexcept {
+    return "};\n";
+  }
+
+  /**
+   * @brief Access specifier labels in order of output, indexed by AccessSpecifier
+   *
+   */
+  static const char *Label(std::size_t index) noexcept {
+    static const char *const labels[] = {" public:\n", " protected:\n", " private:\n"};
+    return labels[index];
+  }
+  static std::size_t LabelSize(std::size_t index) noexcept {
+    static const std::size_t sizes[] = {9, 12, 10};
+    return sizes[index];
+  }
+
+  detail::Body &Section() noexcept {
+    GetArena();
+    return sections_[static_cast<std::size_t>(now_specifier_)];
+  }
+
+  detail::Body &AppendTarget() noexcept {
+    return Section();
+  }
+
+  bool Live() const noexcept {
+    for (const auto &section : sections_) {
+      if (section.Live()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Indent of contents, one level deeper in spaces whatever character own indent is
+   *
+   * @return Indent
+   */
+  Indent ContentIndent() const noexcept {
+    return Indent(indent_.level_ + 1, indent_.size_);
+  }
+
+  std::size_t OutSize(std::size_t prefix_width) const noexcept {
+    const std::size_t indent_width = prefix_width + indent_.Width();
+    std::size_t size = indent_width * 2 + HeaderSize(prefix_width) + kFooterSize;
+    for (std::size_t index = 0; index < sections_.size(); index++) {
+      if (!sections_[index].Empty()) {
+        size += indent_width + LabelSize(index) + sections_[index].OutSize(indent_width + indent_.size_, prefix_width);
+      }
+    }
+    return size;
+  }
+
+  /**
+   * @brief Size of class line, continued at prefix after each newline inside name or base list
+   *
+   * @param prefix_width
+   * @return std::size_t
+   */
+  std::size_t HeaderSize(std::size_t prefix_width) const noexcept {
+    const std::size_t breaks =
+        detail::Breaks(name_.data(), name_.size()) + detail::Breaks(header_.data(), header_.size() - 1);
+    return 6 + name_.size() + header_.size() + breaks * prefix_width;
+  }
+
+  template <typename Sink>
+  void HeaderTo(Sink &sink, const detail::Prefix *prefix) const noexcept {
+    sink.Write("class ", 6);
+    detail::WriteContinued(sink, name_.data(), name_.size(), prefix);
+    detail::WriteContinued(sink, header_.data(), header_.size() - 1, prefix);
+    sink.Write("\n", 1);
+    return;
+  }
+
+  template <typename Sink>
+  void RenderTo(Sink &sink, const detail::Prefix *prefix, RenderCache *cache) const noexcept {
+    const detail::Prefix own_prefix(prefix, indent_);
+    const detail::Prefix content_prefix(prefix, ContentIndent());
+    own_prefix.IndentTo(sink);
+    HeaderTo(sink, prefix);
+    for (std::size_t index = 0; index < sections_.size(); index++) {
+      if (!sections_[index].Empty()) {
+        own_prefix.IndentTo(sink);
+        sink.Write(Label(index), LabelSize(index));
+        sections_[index].RenderTo(sink, content_prefix, prefix, cache);
+      }
+    }
+    own_prefix.IndentTo(sink);
+    sink.Write(Footer(), kFooterSize);
+    return;
+  }
+
+  void Plan(detail::ParallelPlan &plan, const detail::Prefix *prefix) const noexcept {
+    const detail::Prefix *own_prefix = plan.Keep(detail::Prefix(prefix, indent_));
+    const detail::Prefix *content_prefix = plan.Keep(detail::Prefix(prefix, ContentIndent()));
+    const std::size_t indent_width = own_prefix->Width();
+    plan.Add(indent_width + HeaderSize(prefix != nullptr ? prefix->Width() : 0),
+             [this, prefix, own_prefix](BufferSink &sink) {
+               own_prefix->IndentTo(sink);
+               HeaderTo(sink, prefix);
+             });
+    for (std::size_t index = 0; index < sections_.size(); index++) {
+      if (!sections_[index].Empty()) {
+        plan.Add(indent_width + LabelSize(index), [own_prefix, index](BufferSink &sink) {
+          own_prefix->IndentTo(sink);
+          sink.Write(Label(index), LabelSize(index));
+        });
+        sections_[index].Plan(plan, *content_prefix, prefix);
+      }
+    }
+    plan.Add(indent_width + kFooterSize, [own_prefix](BufferSink &sink) {
+      own_prefix->IndentTo(sink);
+      sink.Write(Footer(), kFooterSize);
+    });
+    return;
+  }
+
+  template <typename Sink>
+  void RenderCachedTo(Sink &sink) const noexcept {
+    const detail::Prefix own_prefix(nullptr, indent_);
+    const detail::Prefix content_prefix(nullptr, ContentIndent());
+    const std::uint64_t key = detail::Hasher::Combine(detail::Hasher::kSeed, indent_);
+    own_prefix.IndentTo(sink);
+    sink.Write("class ", 6);
+    sink.Write(name_.data(), name_.size());
+    sink.Write(header_.data(), header_.size());
+    for (std::size_t index = 0; index < sections_.size(); index++) {
+      if (!sections_[index].Empty()) {
+        const std::string &rendered = out_cache_.Render(index, key, sections_[index], content_prefix);
+        own_prefix.IndentTo(sink);
+        sink.Write(Label(index), LabelSize(index));
+        sink.Write(rendered.data(), rendered.size());
+      }
+    }
+    own_prefix.IndentTo(sink);
+    sink.Write(Footer(), kFooterSize);
+    return;
+  }
+
+  Indent indent_;
+  std::string name_;
+  std::string header_;
+  Type type_;
+  AccessSpecifier now_specifier_;
+  std::shared_ptr<Arena> arena_;
+  std::array<detail::Body, 3> sections_;
+  mutable detail::OutCache out_cache_;
+};
+
+namespace detail {
+
+inline void Body::Add(const std::string &, const Snippet &snippet, const std::string &) noexcept {
+  if (Spill(NodeKind::kSnippet, snippet)) {
+    return;
+  }
+  AddSubtree(NodeKind::kSnippet, snippet.Hash(), std::make_shared<const Snippet>(snippet), snippet.Live());
+  return;
+}
+
+inline void Body::Add(const std::string &, const Block &block, const std::string &) noexcept {
+  if (Spill(NodeKind::kBlock, block)) {
+    return;
+  }
+  AddSubtree(NodeKind::kBlock, block.Hash(), std::make_shared<const Block>(block), block.Live());
+  return;
+}
+
+inline void Body::Add(const std::string &, const Class &class_block, const std::string &) noexcept {
+  if (Spill(NodeKind::kClass, class_block)) {
+    return;
+  }
+  AddSubtree(NodeKind::kClass, class_block.Hash(), std::make_shared<const Class>(class_block), class_block.Live());
+  return;
+}
+
+inline void Body::Add(const std::string &, Snippet &&snippet, const std::string &) noexcept {
+  if (Spill(NodeKind::kSnippet, snippet)) {
+    return;
+  }
+  const std::uint64_t hash = snippet.Hash();
+  const bool live = snippet.Live();
+  AddSubtree(NodeKind::kSnippet, hash, std::make_shared<const Snippet>(std::move(snippet)), live);
+  return;
+}
+
+inline void Body::Add(const std::string &, Block &&block, const std::string &) noexcept {
+  if (Spill(NodeKind::kBlock, block)) {
+    return;
+  }
+  const std::uint64_t hash = block.Hash();
+  const bool live = block.Live();
+  AddSubtree(NodeKind::kBlock, hash, std::make_shared<const Block>(std::move(block)), live);
+  return;
+}
+
+inline void Body::Add(const std::string &, Class &&class_block, const std::string &) noexcept {
+  if (Spill(NodeKind::kClass, class_block)) {
+    return;
+  }
+  const std::uint64_t hash = class_block.Hash();
+  const bool live = class_block.Live();
+  AddSubtree(NodeKind::kClass, hash, std::make_shared<const Class>(std::move(class_block)), live);
+  return;
+}
+
+template <typename Node, typename... Args>
+inline Node &Body::Emplace(Args &&...args) noexcept {
+  std::shared_ptr<Node> node = std::make_shared<Node>(std::forward<Args>(args)...);
+  node->SetArena(GetArena());
+  Node &live = *node;
+  AddSubtree(KindOf(&live), 0, std::move(node), true);
+  return live;
+}
+
+template <typename Node>
+inline bool Body::Spill(NodeKind kind, const Node &node) noexcept {
+  if (!spill_ || node.Live()) {
+    return false;
+  }
+  const std::size_t size = node.OutSize(0);
+  if (spill_->Reserve(size)) {
+    return false;
+  }
+  Spilled spilled = {spill_, {0, 0, 0}};
+  if (!spill_->Spill([&node](SpillFile::Writer &writer) { node.RenderTo(writer, nullptr, nullptr); }, size,
+                     spilled.range_)) {
+    return false;
+  }
+  PushSubtree(Own(), {NodeKind::kSpilled, Hasher::Combine(static_cast<std::uint64_t>(kind), node.Hash()),
+                      std::make_shared<const Spilled>(std::move(spilled)), false});
+  return true;
+}
+
+template <typename Sink>
+inline void Body::RenderSpilled(Sink &sink, const Spilled &spilled, const Prefix &prefix) noexcept {
+  char buffer[kSpillReadSize];
+  std::uint64_t offset = spilled.range_.offset_;
+  std::size_t remaining = spilled.range_.size_;
+  bool line_start = true;
+  while (remaining > 0) {
+    const std::size_t chunk = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+    if (!spilled.file_->Read(offset, buffer, chunk)) {
+      return;
+    }
+    const char *begin = buffer;
+    const char *const end = buffer + chunk;
+    while (begin < end) {
+      if (line_start) {
+        prefix.IndentTo(sink);
+      }
+      const char *line_break =
+          static_cast<const char *>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+      line_start = line_break != nullptr;
+      const char *const next = line_start ? line_break + 1 : end;
+      sink.Write(begin, static_cast<std::size_t>(next - begin));
+      begin = next;
+    }
+    offset += chunk;
+    remaining -= chunk;
+  }
+  return;
+}
+
+inline std::uint64_t Body::SubtreeHash(const Subtree &subtree) noexcept {
+  if (!subtree.live_) {
+    return subtree.hash_;
+  }
+  std::uint64_t hash = 0;
+  switch (subtree.kind_) {
+    case NodeKind::kSnippet:
+      hash = static_cast<const Snippet *>(subtree.node_.get())->Hash();
+      break;
+    case NodeKind::kBlock:
+      hash = static_cast<const Block *>(subtree.node_.get())->Hash();
+      break;
+    case NodeKind::kClass:
+      hash = static_cast<const Class *>(subtree.node_.get())->Hash();
+      break;
+    case NodeKind::kSpilled:
+      break;
+  }
+  return Hasher::Combine(static_cast<std::uint64_t>(subtree.kind_), hash);
+}
+
+/**
+ * @brief Top level entries and header bytes in constant time, checked with render cache key
+ *
+ */
+inline std::size_t Body::SubtreeSize(const Subtree &subtree) noexcept {
+  switch (subtree.kind_) {
+    case NodeKind::kSnippet:
+      return static_cast<const Snippet *>(subtree.node_.get())->body_.Entries();
+    case NodeKind::kBlock: {
+      const Block &block = *static_cast<const Block *>(subtree.node_.get());
+      return block.body_.Entries() + block.header_.size();
+    }
+    case NodeKind::kClass: {
+      const Class &class_block = *static_cast<const Class *>(subtree.node_.get());
+      std::size_t size = class_block.header_.size();
+      for (auto &&section : class_block.sections_) {
+        size += section.Entries();
+      }
+      return size;
+    }
+    case NodeKind::kSpilled:
+      return static_cast<const Spilled *>(subtree.node_.get())->range_.size_;
+  }
+  return 0;
+}
+
+inline std::size_t Body::SubtreeOutSize(const Subtree &subtree, std::size_t indent_width) noexcept {
+  switch (subtree.kind_) {
+    case NodeKind::kSnippet:
+      return static_cast<const Snippet *>(subtree.node_.get())->OutSize(indent_width);
+    case NodeKind::kBlock:
+      return static_cast<const Block *>(subtree.node_.get())->OutSize(indent_width);
+    case NodeKind::kClass:
+      return static_cast<const Class *>(subtree.node_.get())->OutSize(indent_width);
+    case NodeKind::kSpilled: {
+      const SpillFile::Range &range = static_cast<const Spilled *>(subtree.node_.get())->range_;
+      return range.size_ + range.lines_ * indent_width;
+    }
+  }
+  return 0;
+}
+
+inline std::size_t Body::OutSize(std::size_t indent_width, std::size_t outer_width) const noexcept {
+  const Storage &storage = Shared();
+  std::size_t size = storage.breaks_ * outer_width;
+  for (const auto &entry : storage.entries_) {
+    if (entry.data_ != nullptr) {
+      size += indent_width + entry.size_ + 1;
+      continue;
+    }
+    size += SubtreeOutSize(storage.subtrees_[entry.size_], indent_width);
+  }
+  return size;
+}
+
+inline void Body::Plan(ParallelPlan &plan, const Prefix &prefix, const Prefix *outer) const noexcept {
+  const std::size_t indent_width = prefix.Width();
+  const std::size_t outer_width = outer != nullptr ? outer->Width() : 0;
+  const Prefix *kept = &prefix;
+  std::size_t first = 0;
+  std::size_t size = 0;
+  auto flush = [this, &plan, kept, outer, &first, &size](std::size_t last) {
+    if (first < last) {
+      plan.Add(size, [this, kept, outer, first, last](BufferSink &sink) {
+        RenderTo(sink, *kept, outer, nullptr, first, last);
+      });
+    }
+    first = last;
+    size = 0;
+  };
+  const Storage &storage = Shared();
+  for (std::size_t index = 0; index < storage.entries_.size(); index++) {
+    const Entry &entry = storage.entries_[index];
+    if (entry.data_ != nullptr) {
+      size += indent_width + entry.size_ + 1;
+      size += storage.breaks_ > 0 ? Breaks(entry.data_, entry.size_) * outer_width : 0;
+    } else {
+      const Subtree &subtree = storage.subtrees_[entry.size_];
+      const std::size_t subtree_size = SubtreeOutSize(subtree, indent_width);
+      if (subtree_size > plan.Grain()) {
+        flush(index);
+        switch (subtree.kind_) {
+          case NodeKind::kSnippet:
+            static_cast<const Snippet *>(subtree.node_.get())->Plan(plan, kept);
+            break;
+          case NodeKind::kBlock:
+            static_cast<const Block *>(subtree.node_.get())->Plan(plan, kept);
+            break;
+          case NodeKind::kClass:
+            static_cast<const Class *>(subtree.node_.get())->Plan(plan, kept);
+            break;
+          case NodeKind::kSpilled:
+            plan.Add(subtree_size, [this, kept, outer, index](BufferSink &sink) {
+              RenderTo(sink, *kept, outer, nullptr, index, index + 1);
+            });
+            break;
+        }
+        first = index + 1;
+        continue;
+      }
+      size += subtree_size;
+    }
+    if (size >= plan.Grain()) {
+      flush(index + 1);
+    }
+  }
+  flush(storage.entries_.size());
+  return;
+}
+
+template <typename Sink>
+inline void Body::RenderSubtree(Sink &sink, const Subtree &subtree, const Prefix &prefix, RenderCache *cache) noexcept {
+  switch (subtree.kind_) {
+    case NodeKind::kSnippet:
+      static_cast<const Snippet *>(subtree.node_.get())->RenderTo(sink, &prefix, cache);
+      break;
+    case NodeKind::kBlock:
+      static_cast<const Block *>(subtree.node_.get())->RenderTo(sink, &prefix, cache);
+      break;
+    case NodeKind::kClass:
+      static_cast<const Class *>(subtree.node_.get())->RenderTo(sink, &prefix, cache);
+      break;
+    case NodeKind::kSpilled:
+      RenderSpilled(sink, *static_cast<const Spilled *>(subtree.node_.get()), prefix);
+      break;
+  }
+  return;
+}
+
+template <typename Sink>
+inline void Body::RenderTo(Sink &sink, const Prefix &prefix, const Prefix *outer, RenderCache *cache,
+                          std::size_t first, std::size_t last) const noexcept {
+  const std::uint64_t prefix_key = cache != nullptr ? prefix.Key() : 0;
+  const Storage &storage = Shared();
+  for (std::size_t index = first; index < storage.entries_.size() && index < last; index++) {
+    const Entry &entry = storage.entries_[index];
+    if (entry.data_ != nullptr) {
+      prefix.IndentTo(sink);
+      if (storage.breaks_ > 0) {
+        WriteContinued(sink, entry.data_, entry.size_, outer);
+      } else {
+        sink.Write(entry.data_, entry.size_);
+      }
+      sink.Write("\n", 1);
+      continue;
+    }
+    const Subtree &subtree = storage.subtrees_[entry.size_];
+    if (cache == nullptr) {
+      RenderSubtree(sink, subtree, prefix, cache);
+      continue;
+    }
+    const std::uint64_t key = Hasher::Combine(SubtreeHash(subtree), prefix_key);
+    const std::size_t size = SubtreeSize(subtree);
+    const std::string *cached = cache->Find(key, size);
+    if (cached != nullptr) {
+      sink.Write(cached->data(), cached->size());
+      continue;
+    }
+    std::string rendered;
+    StringSink rendered_sink(rendered);
+    RenderSubtree(rendered_sink, subtree, prefix, cache);
+    sink.Write(rendered.data(), rendered.size());
+    cache->Store(key, size, std::move(rendered));
+  }
+  return;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Concurrent append into Block or current access specifier of Class, ordered by sequence key
+ *
+ * @tparam Node Block or Class
+ * @details
+ * each producer thread appends into its own Buffer (own lines and arena, no lock).
+ * Merge() moves buffered entries into node ordered by sequence key, without copying line bytes;
+ * equal keys keep order within a buffer, and order of buffer creation between buffers.
+ * node must not be used by other threads during Merge().
+ */
+template <typename Node>
+class ConcurrentAppender {
+ public:
+  /**
+   * @brief Per-thread buffer, submitted to appender on destruction or Submit()
+   *
+   */
+  class Buffer {
+   public:
+    Buffer(ConcurrentAppender *appender, std::size_t order) noexcept : appender_(appender), order_(order) {
+    }
+    ~Buffer() {
+      Submit();
+    }
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+    Buffer(Buffer &&other) noexcept
+        : appender_(other.appender_),
+          order_(other.order_),
+          body_(std::move(other.body_)),
+          records_(std::move(other.records_)) {
+      other.appender_ = nullptr;
+    }
+    Buffer &operator=(Buffer &&) = delete;
+
+    /**
+     * @brief Add any type snippet as Node::Add() does, placed by key on Merge()
+     *
+     * @tparam T
+     * @param key sequence key
+     * @param any
+     */
+    template <typename T>
+    void Add(std::uint64_t key, T &&any) noexcept {
+      const std::size_t first = body_.Entries();
+      const std::uint64_t before = body_.Folded();
+      body_.Add(detail::Body::None(), std::forward<T>(any), detail::Body::None());
+      PushRecord(key, first, before);
+      return;
+    }
+
+    /**
+     * @brief Add one line built from pieces, placed by key on Merge()
+     *
+     * @tparam Pieces
+     * @param key sequence key
+     * @param pieces
+     */
+    template <typename... Pieces>
+    void AddLine(std::uint64_t key, const Pieces &...pieces) noexcept {
+      const std::size_t first = body_.Entries();
+      const std::uint64_t before = body_.Folded();
+      body_.AddLine(detail::Body::None(), detail::Body::None(), pieces...);
+      PushRecord(key, first, before);
+      return;
+    }
+
+    /**
+     * @brief Hand buffered entries to appender, buffer is not usable after this
+     *
+     */
+    void Submit() noexcept {
+      if (appender_ != nullptr) {
+        appender_->Take(*this);
+        appender_ = nullptr;
+      }
+      return;
+    }
+
+   private:
+    friend class ConcurrentAppender;
+
+    typedef struct Record {
+      std::uint64_t key_;
+      std::size_t first_;
+      std::size_t last_;
+      std::uint64_t range_;  // Hasher::Range() of entries, hashed on producer thread
+    } Record;
+
+    void PushRecord(std::uint64_t key, std::size_t first, std::uint64_t before) noexcept {
+      const std::size_t last = body_.Entries();
+      records_.push_back({key, first, last, detail::Hasher::Range(before, body_.Folded(), last - first)});
+      return;
+    }
+
+    ConcurrentAppender *appender_;
+    std::size_t order_;
+    detail::Body body_;
+    std::vector<Record> records_;
+  };
+
+  explicit ConcurrentAppender(Node &node) noexcept : node_(node), buffers_created_(0) {
+  }
+  ~ConcurrentAppender() = default;
+  ConcurrentAppender(const ConcurrentAppender &) = delete;
+  ConcurrentAppender &operator=(const ConcurrentAppender &) = delete;
+  ConcurrentAppender(ConcurrentAppender &&) = delete;
+  ConcurrentAppender &operator=(ConcurrentAppender &&) = delete;
+
+  /**
+   * @brief New buffer for one producer thread
+   *
+   * @return Buffer
+   */
+  Buffer NewBuffer() noexcept {
+    return Buffer(this, buffers_created_.fetch_add(1));
+  }
+
+  /**
+   * @brief Move entries of submitted buffers into node in order of sequence key
+   *
+   * @details
+   * call after all buffers are submitted (e.g. producer threads joined).
+   */
+  void Merge() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::sort(submitted_.begin(), submitted_.end(),
+              [](const Submitted &lhs, const Submitted &rhs) { return lhs.order_ < rhs.order_; });
+    std::vector<Slice> slices;
+    for (std::size_t index = 0; index < submitted_.size(); index++) {
+      for (const auto &record : submitted_[index].records_) {
+        slices.push_back({record.key_, index, record.first_, record.last_, record.range_});
+      }
+    }
+    std::stable_sort(slices.begin(), slices.end(),
+                     [](const Slice &lhs, const Slice &rhs) { return lhs.key_ < rhs.key_; });
+    detail::Body &target = node_.AppendTarget();
+    for (auto &&submitted : submitted_) {
+      if (submitted.records_.empty()) {
+        continue;
+      }
+      const std::shared_ptr<Arena> &arena = submitted.body_.GetArena();
+      if (arena != target.GetArena()) {
+        target.GetArena()->Attach(arena);
+      }
+    }
+    for (const auto &slice : slices) {
+      target.Append(submitted_[slice.buffer_].body_, slice.first_, slice.last_, slice.range_);
+    }
+    submitted_.clear();
+    return;
+  }
+
+ private:
+  typedef struct Submitted {
+    std::size_t order_;
+    detail::Body body_;
+    std::vector<typename Buffer::Record> records_;
+  } Submitted;
+
+  typedef struct Slice {
+    std::uint64_t key_;
+    std::size_t buffer_;
+    std::size_t first_;
+    std::size_t last_;
+    std::uint64_t range_;
+  } Slice;
+
+  void Take(Buffer &buffer) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    submitted_.push_back({buffer.order_, std::move(buffer.body_), std::move(buffer.records_)});
+    return;
+  }
+
+  Node &node_;
+  std::atomic<std::size_t> buffers_created_;
+  std::mutex mutex_;
+  std::vector<Submitted> submitted_;
+};
+
+/**
+ * @brief Block written to sink while built: header on construction, lines and children on add, footer on Close()
+ *
+ * @tparam Sink any type with Write(const char *data, std::size_t size), e.g. FileSink
+ * @details
+ * nothing is kept but indent of parents, so memory does not grow with output; output equals Block::Out().
+ * nested writer is constructed with its parent and closed before the parent is added to again.
+ * not copyable nor movable, parents are referred to while open.
+ */
+template <typename Sink>
+class StreamBlock {
+ public:
+  /**
+   * @brief Open block at top level, header and contents of shape are written first
+   *
+   * @param sink
+   * @param shape e.g. Block(namespace_t, "Generated")
+   */
+  StreamBlock(Sink &sink, const Block &shape) noexcept : StreamBlock(sink, nullptr, shape) {
+  }
+  /**
+   * @brief Open block as child of StreamBlock or StreamClass
+   *
+   * @tparam Parent
+   * @param parent
+   * @param shape
+   */
+  template <typename Parent>
+  StreamBlock(Parent &parent, const Block &shape) noexcept
+      : StreamBlock(parent.Content(), &parent.content_prefix_, shape) {
+  }
+  ~StreamBlock() {
+    Close();
+  }
+  StreamBlock(const StreamBlock &) = delete;
+  StreamBlock &operator=(const StreamBlock &) = delete;
+  StreamBlock(StreamBlock &&) = delete;
+  StreamBlock &operator=(StreamBlock &&) = delete;
+
+  void Add(const std::string &line) noexcept {
+    WriteLine(line.data(), line.size());
+    return;
+  }
+  void Add(const char characters[]) noexcept {
+    WriteLine(characters, std::strlen(characters));
+    return;
+  }
+  void Add(const std::vector<std::string> &lines) noexcept {
+    for (const auto &line : lines) {
+      Add(line);
+    }
+    return;
+  }
+  /**
+   * @brief Write snippet, block and class with indent of this block
+   *
+   * @param snippet
+   */
+  void Add(const Snippet &snippet) noexcept {
+    snippet.RenderTo(Content(), &content_prefix_, nullptr);
+    return;
+  }
+  void Add(const Block &block) noexcept {
+    block.RenderTo(Content(), &content_prefix_, nullptr);
+    return;
+  }
+  void Add(const Class &class_block) noexcept {
+    class_block.RenderTo(Content(), &content_prefix_, nullptr);
+    return;
+  }
+
+  /**
+   * @brief Write one line built from strings, characters, integers and floating points
+   *
+   * @tparam Pieces
+   * @param pieces
+   */
+  template <typename... Pieces>
+  void AddLine(const Pieces &...pieces) noexcept {
+    const detail::Piece formatted[] = {pieces...};
+    content_prefix_.IndentTo(Content());
+    for (const auto &piece : formatted) {
+      detail::WriteContinued(sink_, piece.Data(), piece.Size(), outer_);
+    }
+    sink_.Write("\n", 1);
+    return;
+  }
+
+  /**
+   * @brief Write footer, nothing is written after this
+   *
+   */
+  void Close() noexcept {
+    if (!closed_) {
+      own_prefix_.IndentTo(sink_);
+      sink_.Write(Block::Footer(), Block::kFooterSize);
+      closed_ = true;
+    }
+    return;
+  }
+
+ private:
+  template <typename>
+  friend class StreamBlock;
+  template <typename>
+  friend class StreamClass;
+
+  StreamBlock(Sink &sink, const detail::Prefix *parent, const Block &shape) noexcept
+      : sink_(sink),
+        outer_(parent),
+        own_prefix_(parent, shape.indent_),
+        content_prefix_(parent, shape.ContentIndent()),
+        closed_(false) {
+    own_prefix_.IndentTo(sink_);
+    shape.HeaderTo(sink_, outer_);
+    shape.body_.RenderTo(sink_, content_prefix_, outer_, nullptr);
+  }
+
+  Sink &Content() noexcept {
+    return sink_;
+  }
+
+  void WriteLine(const char *data, std::size_t size) noexcept {
+    content_prefix_.IndentTo(Content());
+    detail::WriteContinued(sink_, data, size, outer_);
+    sink_.Write("\n", 1);
+    return;
+  }
+
+  Sink &sink_;
+  const detail::Prefix *outer_;
+  const detail::Prefix own_prefix_;
+  const detail::Prefix content_prefix_;
+  bool closed_;
+};
+
+/**
+ * @brief Class written to sink while built, same as StreamBlock
+ *
+ * @tparam Sink any type with Write(const char *data, std::size_t size), e.g. FileSink
+ * @details
+ * access specifier label is written before the first content after each change of access specifier,
+ * so contents stay in order of adding instead of being grouped by access specifier as Class::Out() does.
+ */
+template <typename Sink>
+class StreamClass {
+ public:
+  /**
+   * @brief Open class at top level, header and contents of shape are written first
+   *
+   * @param sink
+   * @param shape e.g. Class(struct_t, "Generated"), its access specifier is the initial one
+   */
+  StreamClass(Sink &sink, const Class &shape) noexcept : StreamClass(sink, nullptr, shape) {
+  }
+  /**
+   * @brief Open class as child of StreamBlock or StreamClass
+   *
+   * @tparam Parent
+   * @param parent
+   * @param shape
+   */
+  template <typename Parent>
+  StreamClass(Parent &parent, const Class &shape) noexcept
+      : StreamClass(parent.Content(), &parent.content_prefix_, shape) {
+  }
+  ~StreamClass() {
+    Close();
+  }
+  StreamClass(const StreamClass &) = delete;
+  StreamClass &operator=(const StreamClass &) = delete;
+  StreamClass(StreamClass &&) = delete;
+  StreamClass &operator=(StreamClass &&) = delete;
+
+  void SetAccessSpecifier(AccessSpecifier access_specifier) noexcept {
+    now_specifier_ = access_specifier;
+    return;
+  }
+
+  void Add(const std::string &line) noexcept {
+    WriteLine(line.data(), line.size());
+    return;
+  }
+  void Add(const char characters[]) noexcept {
+    WriteLine(characters, std::strlen(characters));
+    return;
+  }
+  void Add(const std::vector<std::string> &lines) noexcept {
+    for (const auto &line : lines) {
+      Add(line);
+    }
+    return;
+  }
+  /**
+   * @brief Write snippet, block and class with indent of this class into current access specifier
+   *
+   * @param snippet
+   */
+  void Add(const Snippet &snippet) noexcept {
+    snippet.RenderTo(Content(), &content_prefix_, nullptr);
+    return;
+  }
+  void Add(const Block &block) noexcept {
+    block.RenderTo(Content(), &content_prefix_, nullptr);
+    return;
+  }
+  void Add(const Class &class_block) noexcept {
+    class_block.RenderTo(Content(), &content_prefix_, nullptr);
+    return;
+  }
+
+  /**
+   * @brief Write one line built from strings, characters, integers and floating points into current access specifier
+   *
+   * @tparam Pieces
+   * @param pieces
+   */
+  template <typename... Pieces>
+  void AddLine(const Pieces &...pieces) noexcept {
+    const detail::Piece formatted[] = {pieces...};
+    content_prefix_.IndentTo(Content());
+    for (const auto &piece : formatted) {
+      detail::WriteContinued(sink_, piece.Data(), piece.Size(), outer_);
+    }
+    sink_.Write("\n", 1);
+    return;
+  }
+
+  /**
+   * @brief Write footer, nothing is written after this
+   *
+   */
+  void Close() noexcept {
+    if (!closed_) {
+      own_prefix_.IndentTo(sink_);
+      sink_.Write(Class::Footer(), Class::kFooterSize);
+      closed_ = true;
+    }
+    return;
+  }
+
+ private:
+  template <typename>
+  friend class StreamBlock;
+  template <typename>
+  friend class StreamClass;
+
+  static const std::size_t kNoLabel = 3;
+
+  StreamClass(Sink &sink, const detail::Prefix *parent, const Class &shape) noexcept
+      : sink_(sink),
+        outer_(parent),
+        own_prefix_(parent, shape.indent_),
+        content_prefix_(parent, shape.ContentIndent()),
+        now_specifier_(shape.now_specifier_),
+        written_label_(kNoLabel),
+        closed_(false) {
+    own_prefix_.IndentTo(sink_);
+    shape.HeaderTo(sink_, outer_);
+    for (std::size_t index = 0; index < shape.sections_.size(); index++) {
+      if (!shape.sections_[index].Empty()) {
+        WriteLabel(index);
+        shape.sections_[index].RenderTo(sink_, content_prefix_, outer_, nullptr);
+      }
+    }
+  }
+
+  /**
+   * @brief Sink after label of current access specifier, written when changed
+   *
+   * @return Sink&
+   */
+  Sink &Content() noexcept {
+    const std::size_t index = static_cast<std::size_t>(now_specifier_);
+    if (index != written_label_) {
+      WriteLabel(index);
+    }
+    return sink_;
+  }
+
+  void WriteLabel(std::size_t index) noexcept {
+    own_prefix_.IndentTo(sink_);
+    sink_.Write(Class::Label(index), Class::LabelSize(index));
+    written_label_ = index;
+    return;
+  }
+
+  void WriteLine(const char *data, std::size_t size) noexcept {
+    content_prefix_.IndentTo(Content());
+    detail::WriteContinued(sink_, data, size, outer_);
+    sink_.Write("\n", 1);
+    return;
+  }
+
+  Sink &sink_;
+  const detail::Prefix *outer_;
+  const detail::Prefix own_prefix_;
+  const detail::Prefix content_prefix_;
+  AccessSpecifier now_specifier_;
+  std::size_t written_label_;
+  bool closed_;
+};
+
+enum class FileStatus { kUnchanged, kWritten, kFailed };
+
+typedef struct FileResult {
+  std::string path_;
+  FileStatus status_;
+  std::size_t size_;
+} FileResult;
+
+namespace detail {
+
+/**
+ * @brief Unique path of temporary file next to path, written and then renamed over it by ReplaceFile()
+ *
+ * @param path
+ * @return std::string
+ */
+inline std::string TemporaryPath(const std::string &path) noexcept {
+  static std::atomic<std::size_t> temporary_count(0);
+  std::string temporary = path + ".tmp" + std::to_string(temporary_count.fetch_add(1));
+#if defined(__unix__) || defined(__APPLE__)
+  temporary += "." + std::to_string(::getpid());
+#endif
+  return temporary;
+}
+
+/**
+ * @brief Size of open file in 64bit on every platform, seeks to its end
+ *
+ * @param file
+ * @param size
+ * @return true
+ * @return false failed to seek or tell
+ */
+inline bool FileSize(std::FILE *file, std::uint64_t *size) noexcept {
+#if defined(_WIN32)
+  const __int64 end = _fseeki64(file, 0, SEEK_END) == 0 ? _ftelli64(file) : -1;
+#elif defined(__unix__) || defined(__APPLE__)
+  const off_t end = fseeko(file, 0, SEEK_END) == 0 ? ftello(file) : -1;
+#else
+  const long end = std::fseek(file, 0, SEEK_END) == 0 ? std::ftell(file) : -1;
+#endif
+  if (end < 0) {
+    return false;
   }
-  ~Class() = default;
-  Class(const Class &) = default;
-  Class &operator=(const Class &) = default;
-  Class(Class &&) = default;
-  Class &operator=(Class &&) = default;
+  *size = static_cast<std::uint64_t>(end);
+  return true;
+}
+
+/**
+ * @brief Rename written temporary file over path, temporary file is removed on failure
+ *
+ * @param temporary
+ * @param path
+ * @return true
+ * @return false
+ * @details
+ * readers never see a partially written file, and a file mapped by a reader keeps its content.
+ */
+inline bool ReplaceFile(const std::string &temporary, const std::string &path) noexcept {
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    // rename does not replace existing file on some platforms
+    if (std::remove(path.c_str()) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Write rendered node into file only when content differs, keeping timestamp of unchanged file
+ *
+ * @tparam Node Snippet, Block or Class
+ * @param path
+ * @param node
+ * @return FileResult kUnchanged, kWritten or kFailed
+ * @details
+ * existing file of the same size is compared while rendering, without output buffer.
+ * changed content is written into temporary file next to path and renamed over it,
+ * so readers never see a partially written file.
+ */
+template <typename Node>
+inline FileResult WriteIfChanged(const std::string &path, const Node &node) noexcept {
+  FileResult result = {path, FileStatus::kFailed, node.OutSize()};
+  std::FILE *existing = std::fopen(path.c_str(), "rb");
+  if (existing != nullptr) {
+    // size that cannot be told is treated as changed
+    std::uint64_t size = 0;
+    bool equal = detail::FileSize(existing, &size) && size == static_cast<std::uint64_t>(result.size_);
+    equal = equal && std::fseek(existing, 0, SEEK_SET) == 0;
+    if (equal) {
+      CompareSink compare(existing);
+      node.RenderTo(compare);
+      equal = compare.Equal() && std::fgetc(existing) == EOF;
+    }
+    std::fclose(existing);
+    if (equal) {
+      result.status_ = FileStatus::kUnchanged;
+      return result;
+    }
+  }
+
+  const std::string temporary = detail::TemporaryPath(path);
+  std::FILE *file = std::fopen(temporary.c_str(), "wb");
+  if (file == nullptr) {
+    return result;
+  }
+  FileSink sink(file);
+  node.RenderTo(sink);
+  if (std::fclose(file) != 0 || !sink.Good()) {
+    std::remove(temporary.c_str());
+    return result;
+  }
+  if (!detail::ReplaceFile(temporary, path)) {
+    return result;
+  }
+  result.status_ = FileStatus::kWritten;
+  return result;
+}
 
+/**
+ * @brief Set of output files rendered and written in parallel
+ *
+ * @details
+ * file is registered with its root node (kept by project) or with a builder callback; builder root is built
+ * on a worker and freed after writing, so at most job count roots of builders are alive at once.
+ * files are streamed to disk without whole-file buffers, and unchanged files are not rewritten (WriteIfChanged()).
+ * results are in order of registration, and written bytes do not depend on scheduling.
+ */
+class Project {
+ public:
   /**
-   * @brief Out with own indent
+   * @brief Construct a new Project object
    *
-   * @return std::string
+   * @param jobs number of threads of Generate()
    */
-  std::string Out() const noexcept {
-    std::string block = indent_.Indenting() + "class " + name_ + header_;
-    if (!snippets_.at(AccessSpecifier::kPublic).empty()) {
-      block += indent_.Indenting() + " public:\n";
-      for (const auto &snippet : snippets_.at(AccessSpecifier::kPublic)) {
-        block += snippet.Out();
-      }
+  explicit Project(std::size_t jobs = std::thread::hardware_concurrency()) : jobs_(jobs > 0 ? jobs : 1) {
+  }
+
+  std::size_t Jobs() const noexcept {
+    return jobs_;
+  }
+
+  void SetJobs(std::size_t jobs) noexcept {
+    jobs_ = jobs > 0 ? jobs : 1;
+    return;
+  }
+
+  /**
+   * @brief Register file with root node, rvalue is moved
+   *
+   * @tparam Node Snippet, Block or Class
+   * @param path
+   * @param node
+   */
+  template <typename Node>
+  void AddFile(const std::string &path, Node &&node) noexcept {
+    auto root = std::make_shared<Snippet>();
+    root->Add(std::forward<Node>(node));
+    files_.push_back({path, std::move(root), nullptr});
+    return;
+  }
+
+  /**
+   * @brief Register file with builder callback filling root snippet, called on worker thread
+   *
+   * @param path
+   * @param builder
+   */
+  void AddBuilder(const std::string &path, std::function<void(Snippet &)> builder) noexcept {
+    files_.push_back({path, nullptr, std::move(builder)});
+    return;
+  }
+
+  std::size_t Files() const noexcept {
+    return files_.size();
+  }
+
+  /**
+   * @brief Render and write changed files on work-stealing pool of job count threads
+   *
+   * @return std::vector<FileResult> in order of registration
+   */
+  std::vector<FileResult> Generate() const noexcept {
+    WorkStealingPool pool(jobs_);
+    return Generate(pool);
+  }
+
+  /**
+   * @brief Render and write changed files on executor
+   *
+   * @tparam Executor any type with Run(std::size_t count, const std::function<void(std::size_t)> &task)
+   * @param executor
+   * @return std::vector<FileResult> in order of registration
+   */
+  template <typename Executor>
+  std::vector<FileResult> Generate(Executor &executor) const noexcept {
+    std::vector<FileResult> results(files_.size());
+    executor.Run(files_.size(), [this, &results](std::size_t index) { results[index] = WriteFile(files_[index]); });
+    return results;
+  }
+
+ private:
+  typedef struct File {
+    std::string path_;
+    std::shared_ptr<const Snippet> root_;
+    std::function<void(Snippet &)> builder_;
+  } File;
+
+  static FileResult WriteFile(const File &file) noexcept {
+    if (file.root_) {
+      return WriteIfChanged(file.path_, *file.root_);
     }
-    if (!snippets_.at(AccessSpecifier::kProtected).empty()) {
-      block += indent_.Indenting() + " protected:\n";
-      for (const auto &snippet : snippets_.at(AccessSpecifier::kProtected)) {
-        block += snippet.Out();
-      }
+    Snippet root;
+    file.builder_(root);
+    return WriteIfChanged(file.path_, root);
+  }
+
+  std::size_t jobs_;
+  std::vector<File> files_;
+};
+
+namespace detail {
+
+/**
+ * @brief Read-only view of whole file, memory mapped on POSIX and read into memory otherwise
+ *
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &path) noexcept : data_(nullptr), size_(0) {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
     }
-    if (!snippets_.at(AccessSpecifier::kPrivate).empty()) {
-      block += indent_.Indenting() + " private:\n";
-      for (const auto &snippet : snippets_.at(AccessSpecifier::kPrivate)) {
-        block += snippet.Out();
+    struct stat status;
+    if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+      void *mapped = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        data_ = static_cast<const char *>(mapped);
+        size_ = static_cast<std::size_t>(status.st_size);
       }
     }
-    block += indent_.Indenting() + footer_;
-    return block;
+    ::close(fd);
+#else
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+      return;
+    }
+    char buffer[64 * 1024];
+    std::size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      buffer_.append(buffer, read);
+    }
+    std::fclose(file);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+  }
+  ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (data_ != nullptr) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+#endif
   }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&) = delete;
+  MappedFile &operator=(MappedFile &&) = delete;
 
-  Type GetType() const noexcept {
-    return type_;
+  const char *Data() const noexcept {
+    return data_;
   }
 
-  void Add(const std::vector<std::string> &lines) noexcept {
-    for (const auto &line : lines) {
-      Add(line);
+  std::size_t Size() const noexcept {
+    return size_;
+  }
+
+ private:
+  const char *data_;
+  std::size_t size_;
+#if !defined(__unix__) && !defined(__APPLE__)
+  std::string buffer_;
+#endif
+};
+
+/**
+ * @brief Binary tree format of SaveTree() and LoadTree()
+ *
+ * @details
+ * layout in native byte order, every table 8-byte aligned:
+ * Header, blob of line bytes and strings, node table (children before parents, root last), entry table.
+ * a node refers to contiguous entries per body (access specifier of class); an entry is a line in blob
+ * or the index of a child node. loaded lines point into the mapped file, which the arena of loaded nodes keeps.
+ */
+class TreeFile {
+ public:
+  static const std::uint32_t kVersion = 1;
+  static const std::uint32_t kByteOrder = 0x01020304;
+  static const std::uint64_t kSubtree = ~0ULL;
+
+  typedef struct Header {
+    char magic_[4];
+    std::uint32_t version_;
+    std::uint32_t byte_order_;
+    std::uint32_t root_kind_;
+    std::uint64_t blob_offset_;
+    std::uint64_t blob_size_;
+    std::uint64_t nodes_offset_;
+    std::uint64_t node_count_;
+    std::uint64_t entries_offset_;
+    std::uint64_t entry_count_;
+  } Header;
+
+  typedef struct Node {
+    std::uint32_t kind_;
+    std::uint32_t type_;
+    std::uint32_t indent_character_;
+    std::uint32_t access_specifier_;
+    std::uint64_t indent_level_;
+    std::uint64_t indent_size_;
+    std::uint64_t hash_;
+    std::uint64_t strings_[6];
+    std::uint64_t first_[3];
+    std::uint64_t count_[3];
+  } Node;
+
+  typedef struct Entry {
+    std::uint64_t offset_;
+    std::uint64_t size_;
+  } Entry;
+
+  static const char *Magic() noexcept {
+    return "CGTR";
+  }
+
+  template <typename Root>
+  static bool Save(const std::string &path, const Root &root) noexcept {
+    // written aside and renamed, a loaded tree may still read lines from the mapped file at path
+    const std::string temporary = TemporaryPath(path);
+    TreeFile tree;
+    tree.file_ = std::fopen(temporary.c_str(), "wb");
+    if (tree.file_ == nullptr) {
+      return false;
     }
-    return;
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    tree.good_ = std::fwrite(&header, sizeof(header), 1, tree.file_) == 1;
+    tree.SaveNode(root);
+    const char padding[8] = {};
+    tree.Write(padding, (8 - tree.blob_size_ % 8) % 8);
+    std::memcpy(header.magic_, Magic(), 4);
+    header.version_ = kVersion;
+    header.byte_order_ = kByteOrder;
+    header.root_kind_ = static_cast<std::uint32_t>(Kind(&root));
+    header.blob_offset_ = sizeof(header);
+    header.blob_size_ = tree.blob_size_;
+    header.nodes_offset_ = header.blob_offset_ + tree.blob_size_;
+    header.node_count_ = tree.nodes_.size();
+    header.entries_offset_ = header.nodes_offset_ + tree.nodes_.size() * sizeof(Node);
+    header.entry_count_ = tree.entries_.size();
+    tree.good_ = tree.good_ && std::fwrite(tree.nodes_.data(), sizeof(Node), tree.nodes_.size(), tree.file_) ==
+                                   tree.nodes_.size();
+    tree.good_ = tree.good_ && std::fwrite(tree.entries_.data(), sizeof(Entry), tree.entries_.size(), tree.file_) ==
+                                   tree.entries_.size();
+    tree.good_ = tree.good_ && std::fseek(tree.file_, 0, SEEK_SET) == 0 &&
+                 std::fwrite(&header, sizeof(header), 1, tree.file_) == 1;
+    tree.good_ = std::fclose(tree.file_) == 0 && tree.good_;
+    if (!tree.good_) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+    return ReplaceFile(temporary, path);
   }
 
-  template <typename T>
-  void Add(const T &any) noexcept {
-    Snippet snippet_copy(Indent(indent_.level_ + 1, indent_.size_));
-    snippets_[now_specifier_].emplace_back(std::move(snippet_copy << any));
+  template <typename Root>
+  static bool Load(const std::string &path, Root &root) noexcept {
+    std::shared_ptr<const MappedFile> mapped = std::make_shared<const MappedFile>(path);
+    Header header;
+    if (mapped->Size() < sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, mapped->Data(), sizeof(header));
+    if (std::memcmp(header.magic_, Magic(), 4) != 0 || header.version_ != kVersion ||
+        header.byte_order_ != kByteOrder || header.root_kind_ != static_cast<std::uint32_t>(Kind(&root)) ||
+        header.node_count_ == 0 || !Within(header.blob_offset_, header.blob_size_, 1, mapped->Size()) ||
+        !Within(header.nodes_offset_, header.node_count_, sizeof(Node), mapped->Size()) ||
+        !Within(header.entries_offset_, header.entry_count_, sizeof(Entry), mapped->Size())) {
+      return false;
+    }
+    TreeFile tree;
+    tree.blob_ = mapped->Data() + header.blob_offset_;
+    tree.blob_size_ = header.blob_size_;
+    tree.arena_ = std::make_shared<Arena>();
+    tree.arena_->Keep(mapped);
+    tree.built_.resize(static_cast<std::size_t>(header.node_count_));
+    tree.entries_.resize(static_cast<std::size_t>(header.entry_count_));
+    if (!tree.entries_.empty()) {
+      std::memcpy(&tree.entries_[0], mapped->Data() + header.entries_offset_, tree.entries_.size() * sizeof(Entry));
+    }
+    for (std::size_t index = 0; index < tree.built_.size(); index++) {
+      Node node;
+      std::memcpy(&node, mapped->Data() + header.nodes_offset_ + index * sizeof(Node), sizeof(Node));
+      if (!tree.LoadNode(node, index, index + 1 == tree.built_.size() ? &root : nullptr)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  TreeFile() noexcept : file_(nullptr), good_(true), blob_(nullptr), blob_size_(0) {
+  }
+
+  static NodeKind Kind(const cppcodegen::Snippet *) noexcept {
+    return NodeKind::kSnippet;
+  }
+  static NodeKind Kind(const cppcodegen::Block *) noexcept {
+    return NodeKind::kBlock;
+  }
+  static NodeKind Kind(const cppcodegen::Class *) noexcept {
+    return NodeKind::kClass;
+  }
+  static NodeKind Kind(const Body::Spilled *) noexcept {
+    return NodeKind::kSpilled;
+  }
+
+  static bool Within(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::size_t total) noexcept {
+    return offset <= total && count <= (total - offset) / size;
+  }
+
+  std::uint64_t Write(const char *data, std::size_t size) noexcept {
+    const std::uint64_t offset = blob_size_;
+    good_ = good_ && (size == 0 || std::fwrite(data, 1, size, file_) == size);
+    blob_size_ += size;
+    return offset;
+  }
+
+  void WriteString(const std::string &value, std::uint64_t *string) noexcept {
+    string[0] = Write(value.data(), value.size());
+    string[1] = value.size();
     return;
   }
 
-  void IncrementIndent(std::size_t level = 1) noexcept {
-    indent_.level_ += level;
-    for (auto &&each_snippets : snippets_) {
-      for (auto &&snippet : each_snippets.second) {
-        snippet.IncrementIndent(level);
+  Node NewNode(NodeKind kind, Type type, const Indent &indent) noexcept {
+    Node node;
+    std::memset(&node, 0, sizeof(node));
+    node.kind_ = static_cast<std::uint32_t>(kind);
+    node.type_ = static_cast<std::uint32_t>(type);
+    node.indent_character_ = static_cast<unsigned char>(indent.character_);
+    node.indent_level_ = indent.level_;
+    node.indent_size_ = indent.size_;
+    return node;
+  }
+
+  std::uint64_t SaveNode(const cppcodegen::Snippet &snippet) noexcept {
+    Node node = NewNode(NodeKind::kSnippet, snippet.type_, snippet.indent_);
+    WriteString(snippet.header_, &node.strings_[2]);
+    WriteString(snippet.footer_, &node.strings_[4]);
+    SaveBody(snippet.body_, node.first_[0], node.count_[0]);
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  std::uint64_t SaveNode(const cppcodegen::Block &block) noexcept {
+    Node node = NewNode(NodeKind::kBlock, block.type_, block.indent_);
+    WriteString(block.header_, &node.strings_[2]);
+    SaveBody(block.body_, node.first_[0], node.count_[0]);
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  std::uint64_t SaveNode(const cppcodegen::Class &class_block) noexcept {
+    Node node = NewNode(NodeKind::kClass, class_block.type_, class_block.indent_);
+    node.access_specifier_ = static_cast<std::uint32_t>(class_block.now_specifier_);
+    WriteString(class_block.name_, &node.strings_[0]);
+    WriteString(class_block.header_, &node.strings_[2]);
+    for (std::size_t index = 0; index < class_block.sections_.size(); index++) {
+      SaveBody(class_block.sections_[index], node.first_[index], node.count_[index]);
+    }
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  /**
+   * @brief Spilled subtree is saved as snippet of its lines, rendering the same under any indent
+   *
+   */
+  std::uint64_t SaveNode(const Body::Spilled &spilled) noexcept {
+    std::string rendered;
+    StringSink sink(rendered);
+    Body::RenderSpilled(sink, spilled, Prefix(nullptr, Indent(0, 0)));
+    good_ = good_ && rendered.size() == spilled.range_.size_;
+    Node node = NewNode(NodeKind::kSnippet, Type::kLine, Indent(0, kDefaultIndentSize));
+    node.first_[0] = entries_.size();
+    std::size_t begin = 0;
+    while (begin < rendered.size()) {
+      std::size_t end = rendered.find('\n', begin);
+      end = end == std::string::npos ? rendered.size() : end;
+      entries_.push_back({Write(rendered.data() + begin, end - begin), end - begin});
+      begin = end + 1;
+    }
+    node.count_[0] = entries_.size() - node.first_[0];
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+  }
+
+  /**
+   * @brief Save node once however many subtrees refer to it, so it is shared again when loaded
+   *
+   * @tparam Node
+   * @param node
+   * @param hash subtree hash, narrows the nodes compared
+   * @return std::uint64_t index of node
+   * @details
+   * node is the same as a saved one when it is that node, or a copy of it still sharing its contents (Add(const T&)).
+   */
+  template <typename Node>
+  std::uint64_t SaveShared(const Node &node, std::uint64_t hash) noexcept {
+    const auto range = saved_.equal_range(hash);
+    for (auto saved = range.first; saved != range.second; ++saved) {
+      if (saved->second.kind_ == Kind(&node) && Same(node, *static_cast<const Node *>(saved->second.node_))) {
+        return saved->second.index_;
       }
     }
-    return;
+    const std::uint64_t index = SaveNode(node);
+    saved_.insert({hash, {Kind(&node), &node, index}});
+    return index;
   }
 
-  void AddInheritance(const std::string &name, AccessSpecifier access_specifier = AccessSpecifier::kPublic) noexcept {
-    std::string access_specifier_str;
-    if (access_specifier == AccessSpecifier::kPublic) {
-      access_specifier_str = "public";
-    } else if (access_specifier == AccessSpecifier::kProtected) {
-      access_specifier_str = "protected";
-    } else if (access_specifier == AccessSpecifier::kPrivate) {
-      access_specifier_str = "private";
+  static bool Same(const Indent &indent, const Indent &other) noexcept {
+    return indent.level_ == other.level_ && indent.size_ == other.size_ && indent.character_ == other.character_;
+  }
+  static bool Same(const cppcodegen::Snippet &snippet, const cppcodegen::Snippet &other) noexcept {
+    return &snippet == &other ||
+           (snippet.body_.storage_ == other.body_.storage_ && Same(snippet.indent_, other.indent_) &&
+            snippet.type_ == other.type_ && snippet.header_ == other.header_ && snippet.footer_ == other.footer_);
+  }
+  static bool Same(const cppcodegen::Block &block, const cppcodegen::Block &other) noexcept {
+    return &block == &other || (block.body_.storage_ == other.body_.storage_ && Same(block.indent_, other.indent_) &&
+                                block.type_ == other.type_ && block.header_ == other.header_);
+  }
+  static bool Same(const cppcodegen::Class &class_block, const cppcodegen::Class &other) noexcept {
+    if (&class_block == &other) {
+      return true;
     }
-    if (header_.size() < 3 || header_.substr(0, 3) != " : ") {
-      header_.insert(0, " : ");
-      header_.insert(header_.size() - 3, access_specifier_str + " " + name);
-    } else {
-      header_.insert(header_.size() - 3, ", " + access_specifier_str + " " + name);
+    for (std::size_t index = 0; index < class_block.sections_.size(); index++) {
+      if (class_block.sections_[index].storage_ != other.sections_[index].storage_) {
+        return false;
+      }
+    }
+    return Same(class_block.indent_, other.indent_) && class_block.type_ == other.type_ &&
+           class_block.now_specifier_ == other.now_specifier_ && class_block.name_ == other.name_ &&
+           class_block.header_ == other.header_;
+  }
+  static bool Same(const Body::Spilled &spilled, const Body::Spilled &other) noexcept {
+    return &spilled == &other;
+  }
+
+  void SaveBody(const Body &body, std::uint64_t &first, std::uint64_t &count) noexcept {
+    const Body::Storage &storage = body.Shared();
+    std::vector<std::uint64_t> children;
+    for (const auto &subtree : storage.subtrees_) {
+      const std::uint64_t hash = Body::SubtreeHash(subtree);
+      std::uint64_t index = 0;
+      switch (subtree.kind_) {
+        case NodeKind::kSnippet:
+          index = SaveShared(*static_cast<const cppcodegen::Snippet *>(subtree.node_.get()), hash);
+          break;
+        case NodeKind::kBlock:
+          index = SaveShared(*static_cast<const cppcodegen::Block *>(subtree.node_.get()), hash);
+          break;
+        case NodeKind::kClass:
+          index = SaveShared(*static_cast<const cppcodegen::Class *>(subtree.node_.get()), hash);
+          break;
+        case NodeKind::kSpilled:
+          index = SaveShared(*static_cast<const Body::Spilled *>(subtree.node_.get()), hash);
+          break;
+      }
+      nodes_[static_cast<std::size_t>(index)].hash_ = hash;
+      children.push_back(index);
     }
+    first = entries_.size();
+    for (const auto &entry : storage.entries_) {
+      if (entry.data_ != nullptr) {
+        entries_.push_back({Write(entry.data_, entry.size_), entry.size_});
+      } else {
+        entries_.push_back({children[entry.size_], kSubtree});
+      }
+    }
+    count = storage.entries_.size();
     return;
   }
 
-  void SetAccessSpecifier(AccessSpecifier access_specifier) {
-    now_specifier_ = access_specifier;
+  bool String(const std::uint64_t *string, std::string &value) const noexcept {
+    if (!Within(string[0], string[1], 1, static_cast<std::size_t>(blob_size_))) {
+      return false;
+    }
+    value.assign(blob_ + string[0], static_cast<std::size_t>(string[1]));
+    return true;
   }
 
- private:
-  Indent indent_;
-  std::string name_;
-  std::string header_;
-  std::string footer_;
-  Type type_;
-  std::unordered_map<AccessSpecifier, std::vector<Snippet>> snippets_;
-  AccessSpecifier now_specifier_;
+  bool LoadBody(Body &body, std::uint64_t first, std::uint64_t count, std::size_t index) noexcept {
+    if (!Within(first, count, 1, entries_.size())) {
+      return false;
+    }
+    for (std::size_t entry_index = static_cast<std::size_t>(first); entry_index < first + count; entry_index++) {
+      const Entry &entry = entries_[entry_index];
+      if (entry.size_ != kSubtree) {
+        if (!Within(entry.offset_, entry.size_, 1, static_cast<std::size_t>(blob_size_))) {
+          return false;
+        }
+        body.PushLine(blob_ + entry.offset_, static_cast<std::size_t>(entry.size_));
+        continue;
+      }
+      // children are stored before parents
+      if (entry.offset_ >= index || !built_[static_cast<std::size_t>(entry.offset_)].node_) {
+        return false;
+      }
+      Body::PushSubtree(body.Own(), built_[static_cast<std::size_t>(entry.offset_)]);
+    }
+    return true;
+  }
+
+  template <typename Loaded, typename Root>
+  bool Finish(Loaded &&loaded, NodeKind kind, const Node &node, std::size_t index, Root *root) noexcept {
+    if (root != nullptr) {
+      return Assign(*root, std::move(loaded));
+    }
+    built_[index] = {kind, node.hash_, std::make_shared<const Loaded>(std::move(loaded)), false};
+    return true;
+  }
+
+  template <typename Root>
+  static bool Assign(Root &root, Root &&loaded) noexcept {
+    root = std::move(loaded);
+    return true;
+  }
+  template <typename Root, typename Loaded>
+  static bool Assign(Root &, Loaded &&) noexcept {
+    return false;
+  }
+
+  template <typename Root>
+  bool LoadNode(const Node &node, std::size_t index, Root *root) noexcept {
+    if (node.type_ > static_cast<std::uint32_t>(Type::kStruct) ||
+        node.access_specifier_ > static_cast<std::uint32_t>(AccessSpecifier::kPrivate)) {
+      return false;
+    }
+    const Indent indent(static_cast<std::size_t>(node.indent_level_), static_cast<std::size_t>(node.indent_size_),
+                        static_cast<char>(node.indent_character_));
+    switch (static_cast<NodeKind>(node.kind_)) {
+      case NodeKind::kSnippet: {
+        cppcodegen::Snippet snippet(indent);
+        snippet.type_ = static_cast<Type>(node.type_);
+        snippet.SetArena(arena_);
+        if (!String(&node.strings_[2], snippet.header_) || !String(&node.strings_[4], snippet.footer_) ||
+            !LoadBody(snippet.body_, node.first_[0], node.count_[0], index)) {
+          return false;
+        }
+        return Finish(std::move(snippet), NodeKind::kSnippet, node, index, root);
+      }
+      case NodeKind::kBlock: {
+        cppcodegen::Block block(indent);
+        block.type_ = static_cast<Type>(node.type_);
+        block.SetArena(arena_);
+        if (!String(&node.strings_[2], block.header_) || block.header_.empty() ||
+            block.header_.back() != '\n' ||
+            !LoadBody(block.body_, node.first_[0], node.count_[0], index)) {
+          return false;
+        }
+        return Finish(std::move(block), NodeKind::kBlock, node, index, root);
+      }
+      case NodeKind::kClass: {
+        cppcodegen::Class class_block(std::string(), indent);
+        class_block.type_ = static_cast<Type>(node.type_);
+        class_block.now_specifier_ = static_cast<AccessSpecifier>(node.access_specifier_);
+        class_block.SetArena(arena_);
+        if (!String(&node.strings_[0], class_block.name_) || !String(&node.strings_[2], class_block.header_) ||
+            class_block.header_.empty() || class_block.header_.back() != '\n') {
+          return false;
+        }
+        for (std::size_t section = 0; section < class_block.sections_.size(); section++) {
+          if (!LoadBody(class_block.sections_[section], node.first_[section], node.count_[section], index)) {
+            return false;
+          }
+        }
+        return Finish(std::move(class_block), NodeKind::kClass, node, index, root);
+      }
+      case NodeKind::kSpilled:
+        break;
+    }
+    return false;
+  }
+
+  std::FILE *file_;
+  bool good_;
+  const char *blob_;
+  std::uint64_t blob_size_;
+  std::shared_ptr<Arena> arena_;
+  std::vector<Node> nodes_;
+  std::vector<Entry> entries_;
+  std::vector<Body::Subtree> built_;
+
+  typedef struct Saved {
+    NodeKind kind_;
+    const void *node_;
+    std::uint64_t index_;
+  } Saved;
+  std::unordered_multimap<std::uint64_t, Saved> saved_;  // saved subtree nodes by subtree hash
 };
 
+}  // namespace detail
+
+/**
+ * @brief Save tree into versioned binary file, loaded by LoadTree() without rebuilding
+ *
+ * @tparam Node Snippet, Block or Class
+ * @param path
+ * @param node
+ * @return true
+ * @return false file could not be written
+ * @details
+ * file is in native byte order and for this library version only; emplaced children are saved as they are now.
+ * written into temporary file and renamed over path, so a tree loaded from path (even node itself) stays valid.
+ */
+template <typename Node>
+inline bool SaveTree(const std::string &path, const Node &node) noexcept {
+  return detail::TreeFile::Save(path, node);
+}
+
+/**
+ * @brief Load tree saved by SaveTree(), lines are rendered straight from the memory mapped file
+ *
+ * @tparam Node same type as saved
+ * @param path
+ * @param node replaced on success
+ * @return true
+ * @return false missing, truncated, other version or other root type
+ * @details
+ * only tables of nodes and entries are read; line bytes stay in the mapping, kept alive by arena of node
+ * (and of copies and parents it is added to). the file must not be modified in place while loaded;
+ * SaveTree() over it replaces the file instead.
+ */
+template <typename Node>
+inline bool LoadTree(const std::string &path, Node &node) noexcept {
+  return detail::TreeFile::Load(path, node);
+}
+
 /**
  * @brief Stream operator for snippet
  *
@@ -451,8 +4798,8 @@ class Class {
  * @return Snippet&
  */
 template <typename T>
-inline Snippet &operator<<(Snippet &value, const T &another) {
-  value.Add(another);
+inline Snippet &operator<<(Snippet &value, T &&another) {
+  value.Add(std::forward<T>(another));
   return value;
 }
 /**
@@ -464,8 +4811,8 @@ inline Snippet &operator<<(Snippet &value, const T &another) {
  * @return Block&
  */
 template <typename T>
-inline Block &operator<<(Block &value, const T &another) {
-  value.Add(another);
+inline Block &operator<<(Block &value, T &&another) {
+  value.Add(std::forward<T>(another));
   return value;
 }
 /**
@@ -477,8 +4824,8 @@ inline Block &operator<<(Block &value, const T &another) {
  * @return Class&
  */
 template <typename T>
-inline Class &operator<<(Class &value, const T &another) {
-  value.Add(another);
+inline Class &operator<<(Class &value, T &&another) {
+  value.Add(std::forward<T>(another));
   return value;
 }
 /**
@@ -492,5 +4839,46 @@ inline Class &operator<<(Class &value, AccessSpecifier access_specifier) {
   value.SetAccessSpecifier(access_specifier);
   return value;
 }
+/**
+ * @brief Stream operator for streaming block
+ *
+ * @tparam Sink
+ * @tparam T
+ * @param value
+ * @param another
+ * @return StreamBlock<Sink>&
+ */
+template <typename Sink, typename T>
+inline StreamBlock<Sink> &operator<<(StreamBlock<Sink> &value, const T &another) {
+  value.Add(another);
+  return value;
+}
+/**
+ * @brief Stream operator for streaming class
+ *
+ * @tparam Sink
+ * @tparam T
+ * @param value
+ * @param another
+ * @return StreamClass<Sink>&
+ */
+template <typename Sink, typename T>
+inline StreamClass<Sink> &operator<<(StreamClass<Sink> &value, const T &another) {
+  value.Add(another);
+  return value;
+}
+/**
+ * @brief Stream operator for streaming class access specifier
+ *
+ * @tparam Sink
+ * @param value
+ * @param access_specifier
+ * @return StreamClass<Sink>&
+ */
+template <typename Sink>
+inline StreamClass<Sink> &operator<<(StreamClass<Sink> &value, AccessSpecifier access_specifier) {
+  value.SetAccessSpecifier(access_specifier);
+  return value;
+}
 
 }  // namespace cppcodegen
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+
+namespace cppcodegen {
+namespace test {
+
+/**
+ * @brief Number of global operator new calls since process start
+ *
+ * @return std::size_t
+ * @details
+ * counted by replaceable global operator new in allocation_counter.cpp,
+ * linked into unit test and benchmark executables.
+ */
+std::size_t AllocationCount() noexcept;
+
+/**
+ * @brief Number of bytes requested from global operator new since process start
+ *
+ * @return std::size_t
+ */
+std::size_t AllocatedBytes() noexcept;
+
+/**
+ * @brief Count allocations while in scope
+ *
+ */
+class AllocationScope {
+ public:
+  AllocationScope() noexcept : start_(AllocationCount()), start_bytes_(AllocatedBytes()) {
+  }
+
+  std::size_t Count() const noexcept {
+    return AllocationCount() - start_;
+  }
+
+  std::size_t Bytes() const noexcept {
+    return AllocatedBytes() - start_bytes_;
+  }
+
+ private:
+  std::size_t start_;
+  std::size_t start_bytes_;
+};
+
+}  // namespace test
+}  // namespace cppcodegen
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include "allocation_counter.h"
+#include "cppcodegen.h"
+
+// Allocation budgets of common operations.
+// Counted by replaced global operator new (allocation_counter.cpp); raise a budget only with a reason.
+
+TEST(cppcodegenAllocationTest, SnippetAddLine) {
+  cppcodegen::Snippet snippet;
+  snippet << "int a;";
+  {
+    // line bytes go to the arena chunk, at most one entry vector growth
+    cppcodegen::test::AllocationScope scope;
+    snippet << "int b;";
+    EXPECT_LE(scope.Count(), 1u);
+  }
+  {
+    // amortized: vector doubling and arena chunks only
+    cppcodegen::test::AllocationScope scope;
+    for (int line = 0; line < 1000; line++) {
+      snippet << "int c;";
+    }
+    EXPECT_LE(scope.Count(), 24u);
+  }
+  {
+    cppcodegen::test::AllocationScope scope;
+    snippet.AddLine("int member_", 1, " = ", 2.5, ";");
+    EXPECT_LE(scope.Count(), 1u);
+  }
+}
+
+TEST(cppcodegenAllocationTest, BlockAddSnippet) {
+  cppcodegen::Snippet snippet;
+  snippet << "int a;"
+          << "int b;";
+  cppcodegen::Block block(cppcodegen::code_block_t);
+  block << "int c;";
+  {
+    // shared child node, its entry vector, subtree and entry vector growth; no re-render of child lines
+    cppcodegen::test::AllocationScope scope;
+    block << snippet;
+    EXPECT_LE(scope.Count(), 4u);
+  }
+  {
+    cppcodegen::test::AllocationScope scope;
+    block << std::move(snippet);
+    EXPECT_LE(scope.Count(), 3u);
+  }
+}
+
+TEST(cppcodegenAllocationTest, ClassOut) {
+  cppcodegen::Class class_block("TestClass");
+  for (int line = 0; line < 1000; line++) {
+    class_block << "int a;";
+  }
+  {
+    // exact size computed first, then one string
+    cppcodegen::test::AllocationScope scope;
+    const std::string out = class_block.Out();
+    EXPECT_EQ(scope.Count(), 1u);
+    EXPECT_EQ(out.size(), class_block.OutSize());
+  }
+  {
+    std::string out(class_block.OutSize(), '\0');
+    cppcodegen::BufferSink sink(&out[0]);
+    cppcodegen::test::AllocationScope scope;
+    class_block.RenderTo(sink);
+    EXPECT_EQ(scope.Count(), 0u);
+  }
+  {
+    cppcodegen::test::AllocationScope scope;
+    class_block.IncrementIndent();
+    EXPECT_EQ(scope.Count(), 0u);
+  }
+}
+
+TEST(cppcodegenAllocationTest, CacheOutAfterSmallChange) {
+  cppcodegen::Class class_block("TestClass");
+  class_block.CacheOut();
+  for (int line = 0; line < 1000; line++) {
+    class_block << "int a;";
+  }
+  std::string out(class_block.OutSize() + 16, '\0');
+  {
+    cppcodegen::BufferSink sink(&out[0]);
+    class_block.RenderTo(sink);
+  }
+  class_block << "int b;";
+  {
+    // only the new line is rendered, appended to kept bytes (amortized growth)
+    cppcodegen::test::AllocationScope scope;
+    cppcodegen::BufferSink sink(&out[0]);
+    class_block.RenderTo(sink);
+    EXPECT_LE(scope.Count(), 1u);
+  }
+}
+
+TEST(cppcodegenAllocationTest, MoveLargeSubtree) {
+  cppcodegen::Class class_block("TestClass");
+  for (int line = 0; line < 10000; line++) {
+    class_block << "int a;";
+  }
+  cppcodegen::Block other(cppcodegen::namespace_t, "Test");
+  other << std::move(class_block);
+  cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+  block << "int b;";
+  {
+    // shared node and entry growth, independent of subtree size
+    cppcodegen::test::AllocationScope scope;
+    cppcodegen::Class moved("TestClass");
+    for (int line = 0; line < 10000; line++) {
+      moved << "int a;";
+    }
+    const std::size_t building = scope.Count();
+    block << std::move(moved);
+    EXPECT_LE(scope.Count() - building, 3u);
+  }
+  {
+    // entries of other are moved as references, arena of other is attached
+    cppcodegen::test::AllocationScope scope;
+    block.Splice(std::move(other));
+    EXPECT_LE(scope.Count(), 3u);
+  }
+}
+
+TEST(cppcodegenAllocationTest, CopyLargeSubtree) {
+  cppcodegen::Class class_block("TestClass");
+  for (int line = 0; line < 10000; line++) {
+    class_block << "int a;";
+  }
+  cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+  block << "int b;";
+  {
+    // copy shares entries: shared node and entry growth, independent of subtree size
+    cppcodegen::test::AllocationScope scope;
+    for (int copy = 0; copy < 100; copy++) {
+      block << class_block;
+    }
+    EXPECT_LE(scope.Count(), 100u * 2 + 16);
+  }
+  {
+    // first add into a shared copy copies entries and creates own arena once
+    cppcodegen::Class copy = class_block;
+    cppcodegen::test::AllocationScope scope;
+    copy << "int c;";
+    const std::size_t first = scope.Count();
+    copy << "int d;";
+    EXPECT_LE(first, 9u);
+    EXPECT_EQ(scope.Count(), first);
+  }
+}
+
+TEST(cppcodegenAllocationTest, StreamBlock) {
+  cppcodegen::HashSink sink;
+  const cppcodegen::Block shape(cppcodegen::namespace_t, "Test");
+  const cppcodegen::Class class_shape("TestClass");
+  cppcodegen::test::AllocationScope scope;
+  {
+    // nothing is kept, memory does not grow with lines written
+    cppcodegen::StreamBlock<cppcodegen::HashSink> block(sink, shape);
+    cppcodegen::StreamClass<cppcodegen::HashSink> class_block(block, class_shape);
+    for (int line = 0; line < 10000; line++) {
+      class_block.AddLine("int member_", line, ";");
+    }
+  }
+  EXPECT_EQ(scope.Count(), 0u);
+}
+
+TEST(cppcodegenAllocationTest, EmptyNodes) {
+  cppcodegen::test::AllocationScope scope;
+  cppcodegen::Snippet snippet;
+  cppcodegen::Block block(cppcodegen::code_block_t);
+  cppcodegen::Class class_block("TestClass");
+  EXPECT_EQ(scope.Count(), 0u);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "allocation_counter.h"
+#include "cppcodegen.h"
+
+// Scaling tests: build and render trees of growing depth and width,
+// and fail when allocations grow faster than linear in nodes or allocated bytes grow faster than linear in nodes
+// and output. (deep nesting output itself grows with depth * depth because of indentation)
+// counters are deterministic, timing of the same shapes is in bench/.
+
+namespace {
+
+const std::size_t kScale = 8;
+// linear growth gives ratio kScale, quadratic gives kScale * kScale
+const double kAllocationBound = kScale * 1.5;
+// vector and string growth by doubling may allocate up to twice the bytes of a smaller run
+const double kByteSlack = 2.0;
+
+typedef struct Cost {
+  std::size_t allocations_;
+  std::size_t allocated_;
+  std::size_t bytes_;
+} Cost;
+
+/**
+ * @brief Allocations, allocated bytes and output size of build and Out() for size
+ *
+ * @param generate build tree of size and return Out()
+ * @param size
+ * @return Cost
+ */
+Cost Measure(const std::function<std::string(std::size_t)> &generate, std::size_t size) {
+  cppcodegen::test::AllocationScope scope;
+  const std::string out = generate(size);
+  EXPECT_FALSE(out.empty());
+  return Cost{scope.Count(), scope.Bytes(), out.size()};
+}
+
+void ExpectLinear(const std::function<std::string(std::size_t)> &generate, std::size_t size) {
+  const Cost small = Measure(generate, size);
+  const Cost large = Measure(generate, size * kScale);
+  EXPECT_LE(static_cast<double>(large.allocations_), static_cast<double>(small.allocations_) * kAllocationBound)
+      << "allocations " << small.allocations_ << " -> " << large.allocations_;
+  const double work = std::max(static_cast<double>(kScale), static_cast<double>(large.bytes_) / small.bytes_);
+  EXPECT_LE(static_cast<double>(large.allocated_), static_cast<double>(small.allocated_) * work * kByteSlack)
+      << "allocated bytes " << small.allocated_ << " -> " << large.allocated_ << ", output bytes " << small.bytes_
+      << " -> " << large.bytes_;
+}
+
+}  // namespace
+
+TEST(cppcodegenComplexityTest, BlockNestingDepth) {
+  ExpectLinear(
+      [](std::size_t depth) {
+        cppcodegen::Block block(cppcodegen::code_block_t);
+        block << "int a;";
+        for (std::size_t level = 0; level < depth; level++) {
+          cppcodegen::Block parent(cppcodegen::code_block_t);
+          parent << "int a;" << block;
+          block = parent;
+        }
+        return block.Out();
+      },
+      128);
+}
+
+TEST(cppcodegenComplexityTest, NamespaceNestingDepth) {
+  ExpectLinear(
+      [](std::size_t depth) {
+        cppcodegen::Class class_block("TestClass");
+        class_block << "int a;";
+        cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+        block << class_block;
+        for (std::size_t level = 0; level < depth; level++) {
+          cppcodegen::Block parent(cppcodegen::namespace_t, "Test");
+          parent << class_block << std::move(block);
+          block = std::move(parent);
+        }
+        cppcodegen::Snippet file;
+        file << block;
+        return file.Out();
+      },
+      128);
+}
+
+TEST(cppcodegenComplexityTest, ClassMemberWidth) {
+  ExpectLinear(
+      [](std::size_t width) {
+        cppcodegen::Class class_block("TestClass");
+        cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+        getter << "return a;";
+        for (std::size_t member = 0; member < width; member++) {
+          class_block << cppcodegen::AccessSpecifier::kPrivate << "int a;" << cppcodegen::AccessSpecifier::kPublic
+                      << getter;
+        }
+        cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+        block << class_block;
+        return block.Out();
+      },
+      512);
+}
+
+TEST(cppcodegenComplexityTest, NamespaceClassWidth) {
+  ExpectLinear(
+      [](std::size_t width) {
+        cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+        for (std::size_t index = 0; index < width; index++) {
+          cppcodegen::Class class_block("TestClass");
+          class_block << "int a;";
+          block << std::move(class_block);
+        }
+        return block.Out();
+      },
+      256);
+}
+
+TEST(cppcodegenComplexityTest, SpliceIntoNonEmpty) {
+  // splice work depends on spliced entries only: line bytes are neither copied nor hashed again
+  auto splice = [](std::size_t lines, std::size_t line_size) {
+    cppcodegen::Block target(cppcodegen::namespace_t, "Test");
+    target << "int a;";
+    cppcodegen::Block other(cppcodegen::namespace_t, "Test");
+    for (std::size_t line = 0; line < lines; line++) {
+      other << std::string(line_size, 'a');
+    }
+    cppcodegen::test::AllocationScope scope;
+    target.Splice(std::move(other));
+    const Cost cost = {scope.Count(), scope.Bytes(), target.OutSize()};
+    cppcodegen::Block expected(cppcodegen::namespace_t, "Test");
+    expected << "int a;";
+    for (std::size_t line = 0; line < lines; line++) {
+      expected << std::string(line_size, 'a');
+    }
+    EXPECT_EQ(target.Hash(), expected.Hash());
+    return cost;
+  };
+  const Cost small = splice(256, 16);
+  const Cost long_lines = splice(256, 16 * kScale);
+  const Cost many_lines = splice(256 * kScale, 16);
+  EXPECT_EQ(long_lines.allocations_, small.allocations_);
+  EXPECT_EQ(long_lines.allocated_, small.allocated_);
+  EXPECT_LE(static_cast<double>(many_lines.allocations_), static_cast<double>(small.allocations_) * kAllocationBound);
+  EXPECT_LE(static_cast<double>(many_lines.allocated_), static_cast<double>(small.allocated_) * kScale * kByteSlack);
+}
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 #include "cppcodegen.h"
 
 // Tests that don't naturally fit in the headers/.cpp files directly
@@ -300,3 +306,1047 @@ TEST(cppcodegenTest, SpecialMemberFunctionMove) {
   cppcodegen::Snippet line_2(std::move(line));
   EXPECT_EQ(line_2.Out(), "  test\n");
 }
+
+TEST(cppcodegenTest, RenderToSink) {
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  cppcodegen::Class class_block("TestClass");
+  class_block << cppcodegen::AccessSpecifier::kPublic << "TestClass();";
+  block_namespace << class_block;
+
+  std::string buffer;
+  cppcodegen::StringSink string_sink(buffer);
+  block_namespace.RenderTo(string_sink);
+  EXPECT_EQ(buffer, block_namespace.Out());
+
+  std::stringstream stream;
+  cppcodegen::OstreamSink stream_sink(stream);
+  block_namespace.RenderTo(stream_sink);
+  EXPECT_EQ(stream.str(), block_namespace.Out());
+
+  std::FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  cppcodegen::FileSink file_sink(file);
+  class_block.RenderTo(file_sink);
+  EXPECT_TRUE(file_sink.Good());
+  std::rewind(file);
+  std::string file_content(class_block.Out().size(), '\0');
+  EXPECT_EQ(std::fread(&file_content[0], 1, file_content.size(), file), file_content.size());
+  EXPECT_EQ(file_content, class_block.Out());
+  std::fclose(file);
+}
+
+TEST(cppcodegenTest, NestedSubtreeKeepsStructure) {
+  const std::string nested_expected = R"(  namespace Test {
+    class TestClass {
+     public:
+      void Foo() {
+        {
+          int a;
+        }
+      }
+    };
+  }
+)";
+  cppcodegen::Block block_scope(cppcodegen::code_block_t);
+  cppcodegen::Block block_definition(cppcodegen::definition_t, "void Foo()");
+  cppcodegen::Class class_block("TestClass");
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  cppcodegen::Snippet line(cppcodegen::line_t);
+  block_scope << "int a;";
+  block_definition << block_scope;
+  class_block << cppcodegen::AccessSpecifier::kPublic << block_definition;
+  block_namespace << class_block;
+  line << block_namespace;
+  block_scope << "int b;";
+  line.IncrementIndent();
+
+  EXPECT_EQ(line.Out(), nested_expected);
+}
+
+TEST(cppcodegenTest, NestedMultiLine) {
+  const std::string nested_expected = R"(namespace Test {
+  template <typename T>
+  void f() {
+    return;
+  }
+  a
+  b
+      c
+  d
+}
+)";
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  cppcodegen::Block block_definition(cppcodegen::definition_t, "template <typename T>\nvoid f()");
+  cppcodegen::Snippet line;
+  cppcodegen::Snippet line_indented(cppcodegen::Indent(1, 4));
+  block_definition << "return;";
+  line << "a\nb";
+  line_indented << "c\nd";
+  block_namespace << block_definition << line << line_indented;
+
+  EXPECT_EQ(line_indented.Out(), "    c\nd\n");
+  EXPECT_EQ(block_namespace.Out(), nested_expected);
+  EXPECT_EQ(block_namespace.OutSize(), nested_expected.size());
+  cppcodegen::Snippet snippet(cppcodegen::Indent(1, 4));
+  snippet << line;
+  EXPECT_EQ(snippet.Out(), "    a\n    b\n");
+
+  cppcodegen::ThreadPool pool(2);
+  EXPECT_EQ(block_namespace.ParallelOut(pool, 1), nested_expected);
+  std::string streamed;
+  cppcodegen::StringSink sink(streamed);
+  {
+    const cppcodegen::Block shape(cppcodegen::namespace_t, "Test");
+    cppcodegen::StreamBlock<cppcodegen::StringSink> stream_namespace(sink, shape);
+    cppcodegen::StreamBlock<cppcodegen::StringSink> stream_definition(stream_namespace, block_definition);
+  }
+  EXPECT_EQ(streamed, "namespace Test {\n  template <typename T>\n  void f() {\n    return;\n  }\n}\n");
+}
+
+TEST(cppcodegenTest, OutSize) {
+  cppcodegen::Snippet include(cppcodegen::local_include_t, "../");
+  cppcodegen::Block block_definition(cppcodegen::definition_t, "void Foo()", cppcodegen::Indent(1, 4));
+  cppcodegen::Class class_block("TestClass", cppcodegen::Indent(0, 3));
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  cppcodegen::Snippet line(cppcodegen::line_t, cppcodegen::Indent(1, 2, '\t'));
+  include << "test.h";
+  block_definition << "int a;" << include;
+  class_block << cppcodegen::AccessSpecifier::kPublic << block_definition << cppcodegen::AccessSpecifier::kPrivate
+              << "int b;";
+  block_namespace << class_block;
+  line << block_namespace << "";
+  line.IncrementIndent();
+
+  EXPECT_EQ(include.OutSize(), include.Out().size());
+  EXPECT_EQ(block_definition.OutSize(), block_definition.Out().size());
+  EXPECT_EQ(class_block.OutSize(), class_block.Out().size());
+  EXPECT_EQ(block_namespace.OutSize(), block_namespace.Out().size());
+  EXPECT_EQ(line.OutSize(), line.Out().size());
+
+  std::vector<char> buffer(line.OutSize());
+  cppcodegen::BufferSink sink(buffer.data());
+  line.RenderTo(sink);
+  EXPECT_EQ(sink.Cursor(), buffer.data() + buffer.size());
+  EXPECT_EQ(std::string(buffer.begin(), buffer.end()), line.Out());
+}
+
+TEST(cppcodegenTest, IndentWideAndMixedCharacter) {
+  cppcodegen::Snippet wide(cppcodegen::line_t, cppcodegen::Indent(70, 4));
+  cppcodegen::Snippet tab(cppcodegen::line_t, cppcodegen::Indent(1, 1, '\t'));
+  cppcodegen::Block block(cppcodegen::code_block_t, cppcodegen::Indent(1, 2));
+  wide << "wide";
+  tab << "tab";
+  block << tab;
+
+  EXPECT_EQ(wide.Out(), std::string(280, ' ') + "wide\n");
+  EXPECT_EQ(cppcodegen::Indent(3, 2, '\t').Indenting(), std::string(6, '\t'));
+  EXPECT_EQ(block.Out(), "  {\n    \ttab\n  }\n");
+}
+
+TEST(cppcodegenTest, IncrementIndentRelative) {
+  cppcodegen::Class class_before("TestClass");
+  cppcodegen::Class class_after("TestClass");
+  class_before.IncrementIndent(2);
+  class_before << "int a;";
+  class_after << "int a;";
+  class_after.IncrementIndent(2);
+  EXPECT_EQ(class_before.Out(), class_after.Out());
+
+  cppcodegen::Block block_tab(cppcodegen::code_block_t, cppcodegen::Indent(1, 1, '\t'));
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  block_tab << "int a;";
+  block_namespace << block_tab;
+  block_namespace.IncrementIndent();
+  EXPECT_EQ(block_namespace.Out(), "  namespace Test {\n    \t{\n      int a;\n    \t}\n  }\n");
+}
+
+TEST(cppcodegenTest, ContentIndentInSpaces) {
+  cppcodegen::Block block_tab(cppcodegen::code_block_t, cppcodegen::Indent(1, 1, '\t'));
+  cppcodegen::Class class_tab("TestClass", cppcodegen::Indent(0, 1, '\t'));
+  block_tab << "x;";
+  class_tab << cppcodegen::AccessSpecifier::kPublic << "int a;";
+  EXPECT_EQ(block_tab.Out(), "\t{\n  x;\n\t}\n");
+  EXPECT_EQ(block_tab.OutSize(), block_tab.Out().size());
+  EXPECT_EQ(class_tab.Out(), "class TestClass {\n public:\n int a;\n};\n");
+
+  std::string streamed;
+  cppcodegen::StringSink sink(streamed);
+  {
+    cppcodegen::StreamBlock<cppcodegen::StringSink> stream_tab(sink, block_tab);
+  }
+  EXPECT_EQ(streamed, block_tab.Out());
+}
+
+TEST(cppcodegenTest, ArenaLineStorage) {
+  auto arena = std::make_shared<cppcodegen::Arena>();
+  cppcodegen::Snippet include(cppcodegen::system_include_t);
+  cppcodegen::Block block(cppcodegen::code_block_t);
+  include << "vector";
+  include.SetArena(arena);
+  include << "string";
+  block.SetArena(arena);
+  block << "int a;";
+  EXPECT_EQ(arena->Used(), std::string("#include <vector>#include <string>int a;").size());
+  EXPECT_EQ(include.Out(), "#include <vector>\n#include <string>\n");
+
+  cppcodegen::Snippet line(cppcodegen::line_t);
+  {
+    cppcodegen::Block block_copied(block);
+    block_copied << "";
+    line << block_copied;
+  }
+  block << "int b;";
+  arena.reset();
+  EXPECT_EQ(line.Out(), "{\n  int a;\n  \n}\n");
+  EXPECT_EQ(block.Out(), "{\n  int a;\n  int b;\n}\n");
+}
+
+TEST(cppcodegenTest, SynchronizedArena) {
+  EXPECT_FALSE(cppcodegen::Arena().Synchronized());
+  auto arena = std::make_shared<cppcodegen::Arena>(256, true);
+  EXPECT_TRUE(arena->Synchronized());
+  cppcodegen::Snippet snippets[2];
+  std::vector<std::thread> threads;
+  for (auto &snippet : snippets) {
+    snippet.SetArena(arena);
+    threads.emplace_back([&snippet]() {
+      for (int index = 0; index < 1000; index++) {
+        snippet.AddLine("int a", index, ";");
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(snippets[0].Out(), snippets[1].Out());
+  EXPECT_EQ(arena->Used(), 2 * (snippets[0].OutSize() - 1000));
+}
+
+TEST(cppcodegenTest, MoveAdd) {
+  const std::string long_line(300, 'a');
+  const std::string block_expected = "namespace Test {\n  class TestClass {\n   private:\n    " + long_line +
+                                     "\n    int b;\n  };\n  {\n    int c;\n  }\n}\n";
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  cppcodegen::Class class_block("TestClass");
+  cppcodegen::Block block_scope(cppcodegen::code_block_t);
+  std::string line = long_line;
+  class_block << std::move(line) << std::vector<std::string>{"int b;"};
+  block_scope << std::string("int c;");
+  block_namespace << std::move(class_block) << std::move(block_scope);
+
+  EXPECT_EQ(block_namespace.Out(), block_expected);
+}
+
+TEST(cppcodegenTest, AddPieces) {
+  const std::string type = "std::uint32_t";
+  cppcodegen::Snippet include(cppcodegen::system_include_t);
+  cppcodegen::Class class_block("TestClass");
+  include.AddLine("c", "std", 'd', "ef");
+  class_block.Add("static constexpr ", type, " kMin = ", -2147483647 - 1, ";");
+  class_block.Add("static constexpr unsigned long long kMax = ", 18446744073709551615ULL, "ULL;");
+  class_block.Add("static constexpr double kRate = ", 0.1, ", kHalf = ", 0.5f, ", kBig = ", 1e300, ";");
+  class_block.AddLine("static constexpr bool kFlag = ", true, ";");
+
+  EXPECT_EQ(include.Out(), "#include <cstddef>\n");
+  EXPECT_EQ(class_block.Out(), R"(class TestClass {
+ private:
+  static constexpr std::uint32_t kMin = -2147483648;
+  static constexpr unsigned long long kMax = 18446744073709551615ULL;
+  static constexpr double kRate = 0.1, kHalf = 0.5, kBig = 1e+300;
+  static constexpr bool kFlag = true;
+};
+)");
+}
+
+TEST(cppcodegenTest, CompactLineLayout) {
+  EXPECT_EQ(sizeof(cppcodegen::detail::Body::Entry), sizeof(const char *) + sizeof(std::size_t));
+
+  auto arena = std::make_shared<cppcodegen::Arena>();
+  cppcodegen::Class class_block("TestClass");
+  class_block.SetArena(arena);
+  for (int index = 0; index < 1000; index++) {
+    class_block << cppcodegen::AccessSpecifier::kPrivate << "int a;" << cppcodegen::AccessSpecifier::kPublic
+                << "int b;";
+  }
+  EXPECT_EQ(arena->Used(), 2000 * std::string("int a;").size());
+  EXPECT_EQ(class_block.OutSize(), std::string("class TestClass {\n public:\n private:\n};\n").size() + 2000 * 9);
+}
+
+TEST(cppcodegenTest, StructuralHash) {
+  cppcodegen::Block block(cppcodegen::definition_t, "int Get() const");
+  block << "return a;";
+  cppcodegen::Block same_block(cppcodegen::definition_t, "int Get() const");
+  same_block.AddLine("return ", 'a', ";");
+  EXPECT_EQ(block.Hash(), same_block.Hash());
+  same_block << "";
+  EXPECT_NE(block.Hash(), same_block.Hash());
+  cppcodegen::Block indented_block(block);
+  indented_block.IncrementIndent();
+  EXPECT_NE(block.Hash(), indented_block.Hash());
+
+  cppcodegen::Class class_block("TestClass");
+  class_block << cppcodegen::AccessSpecifier::kPublic << block;
+  cppcodegen::Class private_class_block("TestClass");
+  private_class_block << block;
+  EXPECT_NE(class_block.Hash(), private_class_block.Hash());
+}
+
+TEST(cppcodegenTest, RenderCache) {
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  for (int index = 0; index < 100; index++) {
+    cppcodegen::Class class_block("TestClass" + std::to_string(index));
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter;
+    block_namespace << class_block;
+  }
+  cppcodegen::RenderCache cache;
+  EXPECT_EQ(block_namespace.Out(cache), block_namespace.Out());
+  EXPECT_EQ(cache.Hits(), 99u);
+  EXPECT_EQ(cache.Misses(), 101u);
+
+  // same subtree under other indent is another entry
+  cppcodegen::Snippet snippet;
+  snippet << block_namespace;
+  snippet.IncrementIndent();
+  EXPECT_EQ(snippet.Out(cache), snippet.Out());
+  EXPECT_EQ(cache.Misses(), 101u + 102u);
+
+  std::string out;
+  cppcodegen::StringSink sink(out);
+  block_namespace.RenderTo(sink, cache);
+  EXPECT_EQ(out, block_namespace.Out());
+  EXPECT_EQ(cache.Hits(), 99u + 99u + 100u);
+
+  cppcodegen::RenderCache no_capacity(0);
+  EXPECT_EQ(block_namespace.Out(no_capacity), block_namespace.Out());
+  EXPECT_EQ(no_capacity.Hits(), 0u);
+  EXPECT_EQ(no_capacity.Bytes(), 0u);
+
+  // colliding key of subtree with other size is a miss and replaced
+  cppcodegen::RenderCache collision;
+  collision.Store(1, 2, "a\n");
+  EXPECT_EQ(collision.Find(1, 3), nullptr);
+  collision.Store(1, 3, "bc\n");
+  ASSERT_NE(collision.Find(1, 3), nullptr);
+  EXPECT_EQ(*collision.Find(1, 3), "bc\n");
+  EXPECT_EQ(collision.Bytes(), 3u);
+}
+
+TEST(cppcodegenTest, CacheOut) {
+  auto expect_same = [](const cppcodegen::Class &cached) {
+    cppcodegen::Class uncached(cached);
+    uncached.CacheOut(false);
+    EXPECT_EQ(cached.Out(), uncached.Out());
+  };
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Class class_block("TestClass");
+  class_block.CacheOut();
+  class_block << "int a;";
+  expect_same(class_block);
+  class_block << cppcodegen::AccessSpecifier::kPublic << getter;
+  expect_same(class_block);
+  class_block << cppcodegen::AccessSpecifier::kPrivate << "int b;";
+  class_block.AddInheritance("Base");
+  expect_same(class_block);
+  class_block.IncrementIndent();
+  expect_same(class_block);
+  EXPECT_EQ(class_block.Out().size(), class_block.OutSize());
+
+  cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+  cppcodegen::Snippet snippet(cppcodegen::system_include_t);
+  block.CacheOut();
+  snippet.CacheOut();
+  for (int index = 0; index < 3; index++) {
+    snippet << "vector";
+    block << class_block << "int c;";
+    cppcodegen::Snippet uncached_snippet(snippet);
+    uncached_snippet.CacheOut(false);
+    cppcodegen::Block uncached_block(block);
+    uncached_block.CacheOut(false);
+    EXPECT_EQ(snippet.Out(), uncached_snippet.Out());
+    EXPECT_EQ(block.Out(), uncached_block.Out());
+    std::string out;
+    cppcodegen::StringSink sink(out);
+    block.RenderTo(sink);
+    EXPECT_EQ(out, uncached_block.Out());
+  }
+}
+
+TEST(cppcodegenTest, ParallelOut) {
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test", cppcodegen::Indent(1, 4, '\t'));
+  for (int index = 0; index < 200; index++) {
+    cppcodegen::Class class_block("TestClass" + std::to_string(index));
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter << cppcodegen::AccessSpecifier::kPrivate;
+    class_block.AddLine("int member_", index, ";");
+    block_namespace << class_block << "";
+  }
+  cppcodegen::Snippet file;
+  file << "#pragma once" << block_namespace;
+  cppcodegen::Block nested(cppcodegen::code_block_t);
+  nested << file << getter;
+
+  cppcodegen::ThreadPool pool(4);
+  EXPECT_EQ(pool.Size(), 4u);
+  for (std::size_t grain : {1, 64, 4096, 1 << 20}) {
+    EXPECT_EQ(file.ParallelOut(pool, grain), file.Out());
+    EXPECT_EQ(block_namespace.ParallelOut(pool, grain), block_namespace.Out());
+    EXPECT_EQ(nested.ParallelOut(pool, grain), nested.Out());
+  }
+  cppcodegen::Class class_block("Empty");
+  EXPECT_EQ(class_block.ParallelOut(pool), class_block.Out());
+
+  // any executor with Run(count, task)
+  struct SerialExecutor {
+    void Run(std::size_t count, const std::function<void(std::size_t)> &task) {
+      for (std::size_t index = count; index > 0; index--) {
+        task(index - 1);
+      }
+    }
+  } serial;
+  EXPECT_EQ(nested.ParallelOut(serial, 64), nested.Out());
+}
+
+TEST(cppcodegenTest, ConcurrentAppend) {
+  const std::size_t kThreads = 8;
+  const std::size_t kPerThread = 500;
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+
+  cppcodegen::Block expected(cppcodegen::namespace_t, "Test");
+  expected << "// head";
+  for (std::size_t key = 0; key < kThreads * kPerThread; key++) {
+    expected.AddLine("int value_", key, ";");
+    if (key % 100 == 0) {
+      expected << getter;
+    }
+  }
+
+  cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+  block << "// head";
+  cppcodegen::ConcurrentAppender<cppcodegen::Block> appender(block);
+  std::vector<std::thread> threads;
+  for (std::size_t thread = 0; thread < kThreads; thread++) {
+    threads.emplace_back([&appender, &getter, thread]() {
+      auto buffer = appender.NewBuffer();
+      for (std::size_t key = thread; key < kThreads * kPerThread; key += kThreads) {
+        buffer.AddLine(key, "int value_", key, ";");
+        if (key % 100 == 0) {
+          buffer.Add(key, getter);
+        }
+      }
+    });
+  }
+  for (auto &&thread : threads) {
+    thread.join();
+  }
+  appender.Merge();
+  EXPECT_EQ(block.Out(), expected.Out());
+  EXPECT_EQ(block.Hash(), expected.Hash());
+
+  cppcodegen::Class class_block("TestClass");
+  {
+    cppcodegen::ConcurrentAppender<cppcodegen::Class> class_appender(class_block);
+    class_block << cppcodegen::AccessSpecifier::kPublic;
+    auto later = class_appender.NewBuffer();
+    auto earlier = class_appender.NewBuffer();
+    later.Add(2, "int b;");
+    earlier.Add(1, std::string("int a;"));
+    later.Submit();
+    earlier.Submit();
+    class_appender.Merge();
+  }
+  EXPECT_EQ(class_block.Out(), "class TestClass {\n public:\n  int a;\n  int b;\n};\n");
+}
+
+TEST(cppcodegenTest, ConstNodeSharedAcrossThreads) {
+  // same const node added and copied by several builders at once, e.g. prologue of Project files
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Snippet lines;
+  lines << "#pragma once" << getter;
+  const cppcodegen::Snippet prologue(lines);
+  std::vector<std::uint64_t> hashes(4);
+  std::vector<std::string> outs(4);
+  std::vector<std::thread> threads;
+  for (std::size_t index = 0; index < hashes.size(); index++) {
+    threads.emplace_back([&prologue, &hashes, &outs, index]() {
+      const cppcodegen::Snippet copied(prologue);
+      cppcodegen::Snippet root;
+      root << prologue << copied;
+      hashes[index] = root.Hash();
+      outs[index] = root.Out();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  cppcodegen::Snippet root;
+  root << prologue << prologue;
+  for (std::size_t index = 0; index < hashes.size(); index++) {
+    EXPECT_EQ(hashes[index], root.Hash());
+    EXPECT_EQ(outs[index], root.Out());
+  }
+}
+
+TEST(cppcodegenTest, CopiedNodeAppendedAcrossThreads) {
+  // copies of one node share its arena, each copy must add its lines into an arena of its own
+  cppcodegen::Snippet shared_prologue;
+  shared_prologue << "#pragma once";
+  cppcodegen::Class shared_class("TestClass");
+  shared_class << "int a;";
+  const auto arena = shared_prologue.GetArena();
+  const std::size_t used = arena->Used();
+  std::vector<std::string> outs(4);
+  std::vector<std::thread> threads;
+  for (std::size_t index = 0; index < outs.size(); index++) {
+    threads.emplace_back([&shared_prologue, &shared_class, &outs, index]() {
+      cppcodegen::Snippet file = shared_prologue;
+      cppcodegen::Class class_block = shared_class;
+      for (int line = 0; line < 100; line++) {
+        file.AddLine("int b", line, ";");
+        class_block.AddLine("int c", line, ";");
+      }
+      file << class_block;
+      outs[index] = file.Out();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  cppcodegen::Snippet expected = shared_prologue;
+  cppcodegen::Class expected_class = shared_class;
+  for (int line = 0; line < 100; line++) {
+    expected.AddLine("int b", line, ";");
+    expected_class.AddLine("int c", line, ";");
+  }
+  expected << expected_class;
+  for (auto &&out : outs) {
+    EXPECT_EQ(out, expected.Out());
+  }
+  EXPECT_EQ(arena->Used(), used);
+  EXPECT_EQ(shared_prologue.Out(), "#pragma once\n");
+  EXPECT_EQ(shared_class.Out(), "class TestClass {\n private:\n  int a;\n};\n");
+}
+
+TEST(cppcodegenTest, Splice) {
+  std::vector<cppcodegen::Block> parts(4, cppcodegen::Block(cppcodegen::namespace_t, "Test"));
+  std::vector<std::thread> threads;
+  for (std::size_t part = 0; part < parts.size(); part++) {
+    threads.emplace_back([&parts, part]() {
+      cppcodegen::Class class_block("TestClass" + std::to_string(part));
+      class_block.AddLine("int member_", part, ";");
+      parts[part] << "// part " + std::to_string(part) << std::move(class_block);
+    });
+  }
+  for (auto &&thread : threads) {
+    thread.join();
+  }
+  cppcodegen::Block expected(cppcodegen::namespace_t, "Test");
+  for (std::size_t part = 0; part < parts.size(); part++) {
+    cppcodegen::Class class_block("TestClass" + std::to_string(part));
+    class_block.AddLine("int member_", part, ";");
+    expected << "// part " + std::to_string(part) << class_block;
+  }
+  cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+  for (auto &&part : parts) {
+    block.Splice(std::move(part));
+  }
+  parts.clear();
+  EXPECT_EQ(block.Out(), expected.Out());
+  EXPECT_EQ(block.Hash(), expected.Hash());
+
+  // hash joined from spliced body follows emplaced subtree changed after splice
+  cppcodegen::Block live(cppcodegen::namespace_t, "Test");
+  auto &emplaced = live.Emplace<cppcodegen::Block>(cppcodegen::code_block_t);
+  block.Splice(std::move(live));
+  emplaced << "int late;";
+  cppcodegen::Block late(cppcodegen::code_block_t);
+  late << "int late;";
+  expected << late;
+  EXPECT_EQ(block.Out(), expected.Out());
+  EXPECT_EQ(block.Hash(), expected.Hash());
+
+  cppcodegen::Class class_block("TestClass");
+  cppcodegen::Class other("Other", cppcodegen::Indent(1, 4));
+  class_block << "int a;";
+  other << "int b;" << cppcodegen::AccessSpecifier::kPublic << "int c;";
+  class_block.Splice(std::move(other));
+  EXPECT_EQ(class_block.Out(), "class TestClass {\n public:\n  int c;\n private:\n  int a;\n  int b;\n};\n");
+  EXPECT_EQ(other.Out(), "    class Other {\n    };\n");
+
+  // spliced node renders its emptied body, not output cached before
+  cppcodegen::Snippet cached;
+  cppcodegen::Snippet receiver;
+  cached.CacheOut();
+  cached << "x";
+  EXPECT_EQ(cached.Out(), "x\n");
+  receiver.Splice(std::move(cached));
+  EXPECT_EQ(cached.Out(), "");
+  cached << "y";
+  EXPECT_EQ(cached.Out(), "y\n");
+  EXPECT_EQ(cached.OutSize(), cached.Out().size());
+  EXPECT_EQ(receiver.Out(), "x\n");
+
+  cppcodegen::Class cached_class("Cached");
+  cached_class.CacheOut();
+  cached_class << "int a;";
+  EXPECT_EQ(cached_class.Out(), "class Cached {\n private:\n  int a;\n};\n");
+  class_block.Splice(std::move(cached_class));
+  EXPECT_EQ(cached_class.Out(), "class Cached {\n};\n");
+}
+
+TEST(cppcodegenTest, Project) {
+  auto read = [](const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+  };
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+
+  cppcodegen::Project project(4);
+  std::vector<std::string> expected;
+  for (int index = 0; index < 40; index++) {
+    const std::string path = testing::TempDir() + "cppcodegen_project_" + std::to_string(index) + ".h";
+    std::remove(path.c_str());
+    cppcodegen::Class class_block("TestClass" + std::to_string(index));
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter;
+    for (int member = 0; member < index * 10; member++) {
+      class_block.AddLine("int member_", member, ";");
+    }
+    cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+    block_namespace << class_block;
+    if (index % 2 == 0) {
+      expected.push_back(block_namespace.Out());
+      project.AddFile(path, std::move(block_namespace));
+    } else {
+      cppcodegen::Snippet file;
+      file << "#pragma once" << block_namespace;
+      expected.push_back(file.Out());
+      project.AddBuilder(path, [block_namespace](cppcodegen::Snippet &root) {
+        root << "#pragma once" << block_namespace;
+      });
+    }
+  }
+  project.AddFile(testing::TempDir() + "no_such_directory/file.h", getter);
+  EXPECT_EQ(project.Files(), 41u);
+
+  for (std::size_t jobs : {1, 4}) {
+    project.SetJobs(jobs);
+    const auto results = project.Generate();
+    ASSERT_EQ(results.size(), 41u);
+    for (std::size_t index = 0; index < expected.size(); index++) {
+      EXPECT_EQ(results[index].path_, testing::TempDir() + "cppcodegen_project_" + std::to_string(index) + ".h");
+      EXPECT_EQ(results[index].status_,
+                jobs == 1 ? cppcodegen::FileStatus::kWritten : cppcodegen::FileStatus::kUnchanged);
+      EXPECT_EQ(results[index].size_, expected[index].size());
+      EXPECT_EQ(read(results[index].path_), expected[index]);
+    }
+    EXPECT_EQ(results.back().status_, cppcodegen::FileStatus::kFailed);
+  }
+
+  cppcodegen::WorkStealingPool pool(3);
+  EXPECT_EQ(pool.Size(), 3u);
+  EXPECT_EQ(project.Generate(pool).front().status_, cppcodegen::FileStatus::kUnchanged);
+  std::vector<int> counts(1000, 0);
+  pool.Run(counts.size(), [&counts](std::size_t index) { counts[index]++; });
+  EXPECT_EQ(std::count(counts.begin(), counts.end(), 1), 1000);
+}
+
+TEST(cppcodegenTest, WriteIfChanged) {
+  const std::string path = testing::TempDir() + "cppcodegen_write_if_changed.h";
+  std::remove(path.c_str());
+  cppcodegen::Block block(cppcodegen::namespace_t, "Test");
+  block << "int a;";
+  EXPECT_EQ(cppcodegen::WriteIfChanged(path, block).status_, cppcodegen::FileStatus::kWritten);
+  EXPECT_EQ(cppcodegen::WriteIfChanged(path, block).status_, cppcodegen::FileStatus::kUnchanged);
+
+  // same size, different content
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "namespace Test {\n  int b;\n}\n";
+  }
+  EXPECT_EQ(cppcodegen::WriteIfChanged(path, block).status_, cppcodegen::FileStatus::kWritten);
+  block << "int b;";
+  const cppcodegen::FileResult result = cppcodegen::WriteIfChanged(path, block);
+  EXPECT_EQ(result.status_, cppcodegen::FileStatus::kWritten);
+  EXPECT_EQ(result.size_, block.OutSize());
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  EXPECT_EQ(content.str(), block.Out());
+
+  cppcodegen::Project project(2);
+  project.AddFile(path, block);
+  EXPECT_EQ(project.Generate().front().status_, cppcodegen::FileStatus::kUnchanged);
+  EXPECT_EQ(cppcodegen::WriteIfChanged(testing::TempDir() + "no_such_directory/file.h", block).status_,
+            cppcodegen::FileStatus::kFailed);
+}
+
+TEST(cppcodegenTest, HashSink) {
+  auto digest = [](const std::string &bytes) {
+    cppcodegen::HashSink sink;
+    sink.Write(bytes.data(), bytes.size());
+    return sink.Digest();
+  };
+  // XXH64 reference values, seed 0
+  EXPECT_EQ(digest(""), 0xEF46DB3751D8E999ULL);
+  EXPECT_EQ(digest("a"), 0xD24EC4F1A98C6E5BULL);
+  EXPECT_EQ(digest("abc"), 0x44BC2CF5AD770999ULL);
+
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  for (int index = 0; index < 100; index++) {
+    cppcodegen::Class class_block("TestClass" + std::to_string(index));
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter;
+    block_namespace << class_block;
+  }
+  const std::string out = block_namespace.Out();
+  cppcodegen::HashSink sink;
+  block_namespace.RenderTo(sink);
+  EXPECT_EQ(sink.Size(), out.size());
+  EXPECT_EQ(sink.Digest(), digest(out));
+
+  // independent of write boundaries
+  cppcodegen::HashSink split_sink;
+  for (std::size_t offset = 0; offset < out.size(); offset += 7) {
+    split_sink.Write(out.data() + offset, std::min<std::size_t>(7, out.size() - offset));
+  }
+  EXPECT_EQ(split_sink.Digest(), sink.Digest());
+  EXPECT_NE(cppcodegen::HashSink(1).Digest(), cppcodegen::HashSink().Digest());
+}
+
+TEST(cppcodegenTest, CopyOnWrite) {
+  cppcodegen::Class class_block("TestClass");
+  class_block << cppcodegen::AccessSpecifier::kPublic << "int a;";
+  const std::string original = class_block.Out();
+
+  cppcodegen::Class copy = class_block;
+  EXPECT_EQ(copy.Out(), original);
+  copy << "int b;";
+  copy.IncrementIndent();
+  EXPECT_EQ(class_block.Out(), original);
+  EXPECT_NE(copy.Out(), original);
+  class_block << "int c;";
+  EXPECT_EQ(copy.Out().find("int c;"), std::string::npos);
+
+  // one shared template added to many parents
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  cppcodegen::Block first(cppcodegen::namespace_t, "First");
+  cppcodegen::Block second(cppcodegen::namespace_t, "Second");
+  first << class_block;
+  second << class_block << "int d;";
+  class_block << "int e;";
+  block_namespace << first << second;
+  const std::string out = block_namespace.Out();
+  EXPECT_EQ(out.find("int e;"), std::string::npos);
+  EXPECT_EQ(out.find("int d;"), out.rfind("int d;"));
+
+  // spliced storage stays shared with the copy
+  cppcodegen::Block spliced(cppcodegen::namespace_t, "Test");
+  cppcodegen::Block kept = first;
+  spliced.Splice(std::move(first));
+  spliced << "int f;";
+  EXPECT_EQ(kept.Out().find("int f;"), std::string::npos);
+  EXPECT_NE(spliced.Out().find("int f;"), std::string::npos);
+}
+
+TEST(cppcodegenTest, Emplace) {
+  cppcodegen::Block expected(cppcodegen::namespace_t, "Test");
+  {
+    cppcodegen::Class class_block("TestClass");
+    class_block << cppcodegen::AccessSpecifier::kPublic << "int a;";
+    cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+    getter << "return a;";
+    class_block << getter;
+    expected << "int b;" << class_block << "int c;";
+  }
+
+  // skeleton first, contents of children filled later in any order
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  block_namespace << "int b;";
+  cppcodegen::Class &class_block = block_namespace.Emplace<cppcodegen::Class>("TestClass");
+  block_namespace << "int c;";
+  class_block << cppcodegen::AccessSpecifier::kPublic;
+  cppcodegen::Block &getter = class_block.Emplace<cppcodegen::Block>(cppcodegen::definition_t, "int Get() const");
+  cppcodegen::RenderCache cache;
+  block_namespace.CacheOut();
+  const std::string partial = block_namespace.Out();
+  EXPECT_NE(block_namespace.Out(cache), expected.Out());
+  getter << "return a;";
+  EXPECT_NE(block_namespace.Hash(), expected.Hash());
+
+  cppcodegen::Block with_member(cppcodegen::namespace_t, "Test");
+  with_member << "int b;";
+  cppcodegen::Class &member_class = with_member.Emplace<cppcodegen::Class>("TestClass");
+  with_member << "int c;";
+  member_class << cppcodegen::AccessSpecifier::kPublic << "int a;";
+  member_class.Emplace<cppcodegen::Block>(cppcodegen::definition_t, "int Get() const") << "return a;";
+  EXPECT_EQ(with_member.Out(), expected.Out());
+  EXPECT_EQ(with_member.Hash(), expected.Hash());
+
+  // parents holding live children see later changes, also through caches
+  cppcodegen::Snippet file;
+  file << block_namespace;
+  EXPECT_NE(block_namespace.Out(), partial);
+  EXPECT_EQ(block_namespace.Out(cache).find("int a;"), std::string::npos);
+  class_block.Emplace<cppcodegen::Snippet>() << "int a;";
+  EXPECT_NE(block_namespace.Out(cache).find("int a;"), std::string::npos);
+  EXPECT_NE(block_namespace.Out().find("int a;"), std::string::npos);
+  EXPECT_NE(file.Out().find("int a;"), std::string::npos);
+  EXPECT_EQ(file.Out(), block_namespace.Out());
+}
+
+TEST(cppcodegenTest, StreamBlock) {
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Block expected(cppcodegen::namespace_t, "Test");
+  {
+    cppcodegen::Class class_block("TestClass", cppcodegen::Indent(1, 4, '\t'));
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter;
+    class_block << cppcodegen::AccessSpecifier::kPrivate;
+    class_block.AddLine("int a = ", 1, ";");
+    cppcodegen::Block inner(cppcodegen::code_block_t);
+    inner << "int b;";
+    expected << "int c;" << class_block << inner << "int d;";
+  }
+
+  std::string out;
+  cppcodegen::StringSink sink(out);
+  {
+    cppcodegen::Block shape(cppcodegen::namespace_t, "Test");
+    shape << "int c;";
+    cppcodegen::StreamBlock<cppcodegen::StringSink> block_namespace(sink, shape);
+    {
+      cppcodegen::StreamClass<cppcodegen::StringSink> class_block(
+          block_namespace, cppcodegen::Class("TestClass", cppcodegen::Indent(1, 4, '\t')));
+      class_block << cppcodegen::AccessSpecifier::kPublic << getter;
+      class_block << cppcodegen::AccessSpecifier::kPrivate;
+      class_block.AddLine("int a = ", 1, ";");
+    }
+    cppcodegen::StreamBlock<cppcodegen::StringSink> inner(block_namespace, cppcodegen::Block(cppcodegen::code_block_t));
+    inner << "int b;";
+    inner.Close();
+    block_namespace << std::string("int d;");
+    EXPECT_EQ(out.find("};\n}\n"), std::string::npos);  // footer is not written yet
+  }
+  EXPECT_EQ(out, expected.Out());
+
+  // label is written again after each change of access specifier
+  std::string class_out;
+  cppcodegen::StringSink class_sink(class_out);
+  {
+    cppcodegen::StreamClass<cppcodegen::StringSink> class_block(class_sink,
+                                                                cppcodegen::Class(cppcodegen::struct_t, "TestStruct"));
+    class_block << "int a;" << cppcodegen::AccessSpecifier::kPrivate << "int b;"
+                << cppcodegen::AccessSpecifier::kPublic << "int c;";
+  }
+  EXPECT_EQ(class_out, "class TestStruct {\n public:\n  int a;\n private:\n  int b;\n public:\n  int c;\n};\n");
+}
+
+TEST(cppcodegenTest, SpillFile) {
+  auto make_class = [](int index) {
+    cppcodegen::Class class_block("TestClass" + std::to_string(index));
+    cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+    getter << "return a;";
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter << cppcodegen::AccessSpecifier::kPrivate;
+    class_block.AddLine("int a = ", index, ";");
+    return class_block;
+  };
+  cppcodegen::Block expected(cppcodegen::namespace_t, "Test");
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test");
+  const std::size_t class_size = make_class(0).OutSize();
+  auto spill = std::make_shared<cppcodegen::SpillFile>(class_size * 4);
+  block_namespace.SetSpill(spill);
+  for (int index = 0; index < 100; index++) {
+    expected << make_class(index) << "";
+    block_namespace << make_class(index) << "";
+  }
+  EXPECT_GT(spill->Spilled(), 0u);
+  EXPECT_LE(spill->Resident(), class_size * 4);
+
+  // read back under parent indent, also from a nested, indented parent and in parallel
+  EXPECT_EQ(block_namespace.OutSize(), expected.OutSize());
+  EXPECT_EQ(block_namespace.Out(), expected.Out());
+  EXPECT_EQ(block_namespace.Hash(), expected.Hash());
+  cppcodegen::Block outer(cppcodegen::namespace_t, "Outer", cppcodegen::Indent(1, 4, '\t'));
+  cppcodegen::Block expected_outer = outer;
+  outer << block_namespace;
+  expected_outer << expected;
+  EXPECT_EQ(outer.Out(), expected_outer.Out());
+  cppcodegen::ThreadPool pool(4);
+  EXPECT_EQ(outer.ParallelOut(pool, 64), expected_outer.Out());
+  cppcodegen::RenderCache cache;
+  EXPECT_EQ(outer.Out(cache), expected_outer.Out());
+
+  // emplaced subtrees stay in memory
+  cppcodegen::Class &live = block_namespace.Emplace<cppcodegen::Class>("Live");
+  live << "int b;";
+  EXPECT_NE(block_namespace.Out().find("int b;"), std::string::npos);
+  EXPECT_TRUE(spill->Good());
+
+  // line bytes read back as they are, including NUL and newlines inside lines
+  auto spill_all = std::make_shared<cppcodegen::SpillFile>(0);
+  cppcodegen::Snippet content;
+  content << std::string("char a[] = \"\0\";", 16) << "int b =\n    1;";
+  cppcodegen::Block binary(cppcodegen::namespace_t, "Binary");
+  cppcodegen::Block expected_binary = binary;
+  binary.SetSpill(spill_all);
+  binary << content;
+  expected_binary << content;
+  EXPECT_EQ(spill_all->Spilled(), content.OutSize());
+  cppcodegen::Block outer_binary(cppcodegen::code_block_t, cppcodegen::Indent(1, 4, '\t'));
+  cppcodegen::Block expected_outer_binary = outer_binary;
+  outer_binary << binary;
+  expected_outer_binary << expected_binary;
+  EXPECT_EQ(outer_binary.Out(), expected_outer_binary.Out());
+  EXPECT_EQ(outer_binary.OutSize(), expected_outer_binary.OutSize());
+  EXPECT_TRUE(spill_all->Good());
+
+  // node whose children are spilled into the same file reads them back while it is spilled
+  cppcodegen::Snippet leaf;
+  for (int index = 0; index < 2000; index++) {
+    leaf.AddLine("int leaf_", index, ";");
+  }
+  cppcodegen::Block inner(cppcodegen::namespace_t, "Inner");
+  cppcodegen::Block nested(cppcodegen::namespace_t, "Nested");
+  cppcodegen::Block expected_inner = inner;
+  cppcodegen::Block expected_nested = nested;
+  inner.SetSpill(spill_all);
+  nested.SetSpill(spill_all);
+  inner << leaf;
+  nested << inner;
+  expected_inner << leaf;
+  expected_nested << expected_inner;
+  cppcodegen::Snippet root;
+  root << nested;
+  EXPECT_EQ(root.Out(), expected_nested.Out());
+  EXPECT_EQ(spill_all->Spilled(), content.OutSize() + leaf.OutSize() + expected_inner.OutSize());
+  EXPECT_TRUE(spill_all->Good());
+}
+
+TEST(cppcodegenTest, SaveLoadTree) {
+  cppcodegen::Block getter(cppcodegen::definition_t, "int Get() const");
+  getter << "return a;";
+  cppcodegen::Snippet file;
+  cppcodegen::Snippet include(cppcodegen::local_include_t, "generated/");
+  include << "header.h";
+  cppcodegen::Block block_namespace(cppcodegen::namespace_t, "Test", cppcodegen::Indent(0, 4, '\t'));
+  auto spill = std::make_shared<cppcodegen::SpillFile>(0);
+  for (int index = 0; index < 20; index++) {
+    cppcodegen::Class class_block(cppcodegen::class_t, "TestClass" + std::to_string(index),
+                                  {{cppcodegen::AccessSpecifier::kPublic, "Base"}});
+    class_block << cppcodegen::AccessSpecifier::kPublic << getter << cppcodegen::AccessSpecifier::kPrivate;
+    class_block.AddLine("int a = ", index, ";");
+    if (index == 10) {
+      block_namespace.SetSpill(spill);
+    }
+    block_namespace << class_block;
+  }
+  block_namespace.Emplace<cppcodegen::Block>(cppcodegen::code_block_t) << "int b;";
+  file << "#pragma once" << include << "" << block_namespace;
+
+  const std::string path = testing::TempDir() + "cppcodegen_tree.bin";
+  ASSERT_TRUE(cppcodegen::SaveTree(path, file));
+  cppcodegen::Snippet loaded;
+  ASSERT_TRUE(cppcodegen::LoadTree(path, loaded));
+  const std::string out = file.Out();
+  EXPECT_EQ(loaded.Out(), out);
+  EXPECT_EQ(loaded.Hash(), file.Hash());
+  EXPECT_EQ(loaded.GetArena()->Used(), 0u);  // lines point into the mapped file
+
+  // loaded tree is an ordinary tree: added to, indented, copied after the loaded root is gone
+  cppcodegen::Block outer(cppcodegen::namespace_t, "Outer");
+  {
+    cppcodegen::Snippet scoped;
+    ASSERT_TRUE(cppcodegen::LoadTree(path, scoped));
+    scoped << "int c;";
+    outer << std::move(scoped);
+  }
+  cppcodegen::Block expected_outer(cppcodegen::namespace_t, "Outer");
+  file << "int c;";
+  expected_outer << file;
+  EXPECT_EQ(outer.Out(), expected_outer.Out());
+
+  // saving over the file a loaded tree reads from replaces it, the loaded tree stays valid
+  cppcodegen::Snippet resaved;
+  ASSERT_TRUE(cppcodegen::LoadTree(path, resaved));
+  resaved << "int d;";
+  ASSERT_TRUE(cppcodegen::SaveTree(path, resaved));
+  EXPECT_EQ(loaded.Out(), out);
+  EXPECT_EQ(resaved.Out(), out + "int d;\n");
+  cppcodegen::Snippet reloaded;
+  ASSERT_TRUE(cppcodegen::LoadTree(path, reloaded));
+  EXPECT_EQ(reloaded.Out(), resaved.Out());
+
+  // other root type, missing and truncated files are rejected
+  cppcodegen::Block wrong_type;
+  EXPECT_FALSE(cppcodegen::LoadTree(path, wrong_type));
+  EXPECT_FALSE(cppcodegen::LoadTree(testing::TempDir() + "no_such_tree.bin", loaded));
+  std::string bytes;
+  {
+    std::ifstream stream(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  const std::string truncated_path = testing::TempDir() + "cppcodegen_tree_truncated.bin";
+  {
+    std::ofstream stream(truncated_path, std::ios::binary | std::ios::trunc);
+    stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 8));
+  }
+  EXPECT_FALSE(cppcodegen::LoadTree(truncated_path, loaded));
+  EXPECT_EQ(loaded.Out(), out);
+
+  // corrupt file with empty header of block or class is rejected
+  auto expect_empty_header_rejected = [&truncated_path](const cppcodegen::Snippet &root) {
+    ASSERT_TRUE(cppcodegen::SaveTree(truncated_path, root));
+    std::string corrupt;
+    {
+      std::ifstream stream(truncated_path, std::ios::binary);
+      corrupt.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+    // nodes offset at 32 in file header, length of header string at 64 in node, the child is the first node
+    std::uint64_t nodes_offset = 0;
+    std::memcpy(&nodes_offset, corrupt.data() + 32, sizeof(nodes_offset));
+    const std::uint64_t zero = 0;
+    std::memcpy(&corrupt[static_cast<std::size_t>(nodes_offset) + 64], &zero, sizeof(zero));
+    {
+      std::ofstream stream(truncated_path, std::ios::binary | std::ios::trunc);
+      stream.write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+    }
+    cppcodegen::Snippet corrupt_loaded;
+    EXPECT_FALSE(cppcodegen::LoadTree(truncated_path, corrupt_loaded));
+  };
+  cppcodegen::Snippet block_root;
+  block_root << cppcodegen::Block(cppcodegen::namespace_t, "Test");
+  expect_empty_header_rejected(block_root);
+  cppcodegen::Snippet class_root;
+  class_root << cppcodegen::Class("TestClass");
+  expect_empty_header_rejected(class_root);
+  std::remove(truncated_path.c_str());
+
+  // subtree shared by copies is saved once and shared again when loaded
+  cppcodegen::Block shared_getter(cppcodegen::definition_t, "int Get() const");
+  for (int index = 0; index < 100; index++) {
+    shared_getter.AddLine("a += ", index, ";");
+  }
+  cppcodegen::Block classes(cppcodegen::namespace_t, "Classes");
+  for (int index = 0; index < 50; index++) {
+    cppcodegen::Class class_block("TestClass" + std::to_string(index));
+    class_block << cppcodegen::AccessSpecifier::kPublic << shared_getter;
+    classes << class_block;
+  }
+  ASSERT_TRUE(cppcodegen::SaveTree(path, classes));
+  std::ifstream saved(path, std::ios::binary | std::ios::ate);
+  EXPECT_LT(static_cast<std::size_t>(saved.tellg()), shared_getter.OutSize() * 50 / 4);  // getter saved once
+  cppcodegen::Block loaded_classes;
+  ASSERT_TRUE(cppcodegen::LoadTree(path, loaded_classes));
+  EXPECT_EQ(loaded_classes.Out(), classes.Out());
+  EXPECT_EQ(loaded_classes.Hash(), classes.Hash());
+  std::remove(path.c_str());
+}